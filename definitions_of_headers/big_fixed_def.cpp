@@ -0,0 +1,249 @@
+#include <big_fixed.h>
+#include <cmath>
+#include <algorithm>
+
+namespace
+{
+    constexpr double twoTo32 = 4294967296.0;
+
+    // a and b must have the same amount of limbs
+    int compareMagnitudes(const std::vector<uint32_t> &a, const std::vector<uint32_t> &b)
+    {
+        for (size_t k = 0; k < a.size(); ++k)
+        {
+            if (a[k] != b[k])
+            {
+                return a[k] < b[k] ? -1 : 1;
+            }
+        }
+        return 0;
+    }
+
+    std::vector<uint32_t> addMagnitudes(const std::vector<uint32_t> &a, const std::vector<uint32_t> &b)
+    {
+        std::vector<uint32_t> result(a.size());
+        uint64_t carry = 0;
+        for (size_t k = a.size(); k-- > 0;)
+        {
+            uint64_t sum = uint64_t(a[k]) + b[k] + carry;
+            result[k] = uint32_t(sum);
+            carry = sum >> 32;
+        }
+        return result;
+    }
+
+    // |a| >= |b|
+    std::vector<uint32_t> subtractMagnitudes(const std::vector<uint32_t> &a, const std::vector<uint32_t> &b)
+    {
+        std::vector<uint32_t> result(a.size());
+        int64_t borrow = 0;
+        for (size_t k = a.size(); k-- > 0;)
+        {
+            int64_t difference = int64_t(a[k]) - b[k] - borrow;
+            borrow = difference < 0;
+            result[k] = uint32_t(difference + (borrow << 32));
+        }
+        return result;
+    }
+
+    BigFixed withLimbCount(const BigFixed &a, size_t limbCount)
+    {
+        BigFixed result = a;
+        result.limbs.resize(limbCount, 0);
+        return result;
+    }
+
+    bool isZero(const std::vector<uint32_t> &limbs)
+    {
+        return std::all_of(limbs.begin(), limbs.end(), [](uint32_t limb)
+                           { return limb == 0; });
+    }
+
+    BigFixed addSigned(const BigFixed &a_, const BigFixed &b_, bool negateB)
+    {
+        size_t limbCount = std::max(a_.limbs.size(), b_.limbs.size());
+        BigFixed a = withLimbCount(a_, limbCount);
+        BigFixed b = withLimbCount(b_, limbCount);
+        b.isNegative = b.isNegative != negateB;
+
+        BigFixed result;
+        if (a.isNegative == b.isNegative)
+        {
+            result.limbs = addMagnitudes(a.limbs, b.limbs);
+            result.isNegative = a.isNegative;
+        }
+        else if (compareMagnitudes(a.limbs, b.limbs) >= 0)
+        {
+            result.limbs = subtractMagnitudes(a.limbs, b.limbs);
+            result.isNegative = a.isNegative;
+        }
+        else
+        {
+            result.limbs = subtractMagnitudes(b.limbs, a.limbs);
+            result.isNegative = b.isNegative;
+        }
+
+        if (isZero(result.limbs))
+        {
+            result.isNegative = false;
+        }
+        return result;
+    }
+}
+
+int fractionalLimbsForZoom(double zoom)
+{
+    double bitsBelowOne = (zoom < 1) ? -std::log2(zoom) : 0;
+    return int(std::ceil((bitsBelowOne + 64) / 32)) + 1;
+}
+
+BigFixed bigFixedFromDouble(double value, int fractionalLimbs)
+{
+    BigFixed result;
+    result.isNegative = value < 0;
+    result.limbs.resize(fractionalLimbs + 1);
+
+    // every step moves the next 32 bits above the point, exact because a double has 53 bits
+    double magnitude = std::fabs(value);
+    for (int k = 0; k <= fractionalLimbs; ++k)
+    {
+        double limb = std::floor(magnitude);
+        result.limbs[k] = uint32_t(limb);
+        magnitude = (magnitude - limb) * twoTo32;
+    }
+
+    if (isZero(result.limbs))
+    {
+        result.isNegative = false;
+    }
+    return result;
+}
+
+bool bigFixedFromString(const std::string &decimal, int fractionalLimbs, BigFixed &result)
+{
+    size_t position = 0;
+    bool isNegative = false;
+    if (position < decimal.size() && (decimal[position] == '-' || decimal[position] == '+'))
+    {
+        isNegative = decimal[position] == '-';
+        ++position;
+    }
+
+    size_t point = decimal.find('.', position);
+    std::string whole = decimal.substr(position, (point == std::string::npos) ? std::string::npos : point - position);
+    std::string fraction = (point == std::string::npos) ? "" : decimal.substr(point + 1);
+    auto isAllDigits = [](const std::string &digits)
+    {
+        return std::all_of(digits.begin(), digits.end(), [](char c)
+                           { return c >= '0' && c <= '9'; });
+    };
+    if ((whole.empty() && fraction.empty()) || !isAllDigits(whole) || !isAllDigits(fraction) || whole.size() > 9)
+    {
+        return false;
+    }
+
+    result.limbs.assign(fractionalLimbs + 1, 0);
+
+    // the fraction from its last digit to its first: x = (digit + x) / 10. x stays below 1, so the
+    // digit goes into the integer limb and the division carries its remainder down the rest
+    for (size_t k = fraction.size(); k-- > 0;)
+    {
+        result.limbs[0] = fraction[k] - '0';
+        uint64_t remainder = 0;
+        for (uint32_t &limb : result.limbs)
+        {
+            uint64_t current = (remainder << 32) | limb;
+            limb = uint32_t(current / 10);
+            remainder = current % 10;
+        }
+    }
+    result.limbs[0] = whole.empty() ? 0 : uint32_t(std::stoul(whole));
+
+    result.isNegative = isNegative && !isZero(result.limbs);
+    return true;
+}
+
+double bigFixedToDouble(const BigFixed &a)
+{
+    double result = 0;
+    for (size_t k = a.limbs.size(); k-- > 0;)
+    {
+        result = result / twoTo32 + a.limbs[k];
+    }
+    return a.isNegative ? -result : result;
+}
+
+// the first howMany doubles of a, each one the rounded rest of what the previous ones missed
+static void peelDoubles(const BigFixed &a, double out[], int howMany)
+{
+    BigFixed rest = a;
+    int fractionalLimbs = int(a.limbs.size()) - 1;
+    for (int k = 0; k < howMany; ++k)
+    {
+        out[k] = bigFixedToDouble(rest);
+        rest = rest - bigFixedFromDouble(out[k], fractionalLimbs);
+    }
+}
+
+DoubleDouble bigFixedToDoubleDouble(const BigFixed &a)
+{
+    double parts[2];
+    peelDoubles(a, parts, 2);
+    return {parts[0], parts[1]};
+}
+
+QuadDouble bigFixedToQuadDouble(const BigFixed &a)
+{
+    double parts[4];
+    peelDoubles(a, parts, 4);
+    return {parts[0], parts[1], parts[2], parts[3]};
+}
+
+BigFixed operator+(const BigFixed &a, const BigFixed &b)
+{
+    return addSigned(a, b, false);
+}
+
+BigFixed operator-(const BigFixed &a, const BigFixed &b)
+{
+    return addSigned(a, b, true);
+}
+
+BigFixed operator*(const BigFixed &a, const BigFixed &b)
+{
+    size_t limbCount = std::max(a.limbs.size(), b.limbs.size());
+    size_t lastLimb = limbCount - 1;
+
+    // column k collects every partial product of weight 2^(-32k). The low and high halves of each
+    // 64 bit product are summed separately so a column can't overflow; products entirely below the
+    // last kept limb (plus one guard limb) are dropped
+    std::vector<uint64_t> columns(limbCount + 1, 0);
+    for (size_t i = 0; i < a.limbs.size(); ++i)
+    {
+        for (size_t j = 0; j < b.limbs.size() && i + j <= lastLimb + 1; ++j)
+        {
+            uint64_t product = uint64_t(a.limbs[i]) * b.limbs[j];
+            columns[i + j] += product & 0xFFFFFFFFu;
+            if (i + j > 0)
+            {
+                columns[i + j - 1] += product >> 32;
+            }
+        }
+    }
+
+    BigFixed result;
+    result.limbs.resize(limbCount);
+    uint64_t carry = 0;
+    for (size_t k = limbCount + 1; k-- > 0;)
+    {
+        uint64_t total = columns[k] + carry;
+        if (k <= lastLimb)
+        {
+            result.limbs[k] = uint32_t(total);
+        }
+        carry = total >> 32;
+    }
+
+    result.isNegative = (a.isNegative != b.isNegative) && !isZero(result.limbs);
+    return result;
+}
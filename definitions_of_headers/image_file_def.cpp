@@ -0,0 +1,165 @@
+#include <image_file.h>
+#include <cstdio>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+namespace
+{
+    // PNG chunks end with the CRC-32 of their type and data
+    uint32_t crc32(const unsigned char data[], size_t size, uint32_t crc = 0)
+    {
+        static uint32_t table[256];
+        static bool isTableReady = false;
+        if (!isTableReady)
+        {
+            for (uint32_t n = 0; n < 256; ++n)
+            {
+                uint32_t c = n;
+                for (int k = 0; k < 8; ++k)
+                {
+                    c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+                }
+                table[n] = c;
+            }
+            isTableReady = true;
+        }
+
+        crc = ~crc;
+        for (size_t k = 0; k < size; ++k)
+        {
+            crc = table[(crc ^ data[k]) & 0xff] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+    void appendBigEndian(std::vector<unsigned char> &out, uint32_t value)
+    {
+        out.push_back(value >> 24);
+        out.push_back(value >> 16);
+        out.push_back(value >> 8);
+        out.push_back(value);
+    }
+
+    void writeChunk(FILE *file, const char type[4], const std::vector<unsigned char> &data)
+    {
+        std::vector<unsigned char> chunk;
+        appendBigEndian(chunk, data.size());
+        chunk.insert(chunk.end(), type, type + 4);
+        chunk.insert(chunk.end(), data.begin(), data.end());
+        appendBigEndian(chunk, crc32(chunk.data() + 4, chunk.size() - 4));
+        fwrite(chunk.data(), 1, chunk.size(), file);
+    }
+}
+
+namespace imageFile
+{
+    bool beginImage(ImageStream &image, const std::string &path, int width, int height)
+    {
+        image = ImageStream{};
+        image.file = fopen(path.c_str(), "wb");
+        if (image.file == nullptr)
+        {
+            return false;
+        }
+        image.isPNG = path.size() >= 4 && path.compare(path.size() - 4, 4, ".png") == 0;
+        image.width = width;
+        image.height = height;
+
+        if (!image.isPNG)
+        {
+            fprintf(image.file, "P6\n%d %d\n255\n", width, height);
+            return true;
+        }
+
+        const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+        fwrite(signature, 1, 8, image.file);
+
+        std::vector<unsigned char> header;
+        appendBigEndian(header, width);
+        appendBigEndian(header, height);
+        header.insert(header.end(), {8, 2, 0, 0, 0}); // 8 bits per channel, RGB, deflate, no filter choice, no interlacing
+        writeChunk(image.file, "IHDR", header);
+        return true;
+    }
+
+    // a PNG row is its filter type (0, none) and the pixels. Each goes out as an IDAT chunk of its
+    // own, holding the next stored deflate blocks (at most 65535 bytes each) of one zlib stream that
+    // runs across all of them
+    static void writePNGRow(ImageStream &image, const unsigned char pixels[])
+    {
+        std::vector<unsigned char> row(size_t(image.width) * 3 + 1);
+        row[0] = 0;
+        std::copy(pixels, pixels + size_t(image.width) * 3, row.begin() + 1);
+
+        bool isFirstRow = image.rowsWritten == 0;
+        bool isLastRow = image.rowsWritten == image.height - 1;
+
+        std::vector<unsigned char> data;
+        if (isFirstRow)
+        {
+            data = {0x78, 0x01};
+        }
+        for (size_t begin = 0; begin < row.size(); begin += 65535)
+        {
+            size_t size = std::min<size_t>(65535, row.size() - begin);
+            data.push_back(isLastRow && begin + size == row.size());
+            data.push_back(size & 0xff);
+            data.push_back(size >> 8);
+            data.push_back(~size & 0xff);
+            data.push_back((~size >> 8) & 0xff);
+            data.insert(data.end(), row.begin() + begin, row.begin() + begin + size);
+        }
+        for (unsigned char byte : row)
+        {
+            image.adlerA = (image.adlerA + byte) % 65521;
+            image.adlerB = (image.adlerB + image.adlerA) % 65521;
+        }
+        if (isLastRow)
+        {
+            appendBigEndian(data, (image.adlerB << 16) | image.adlerA);
+        }
+        writeChunk(image.file, "IDAT", data);
+    }
+
+    bool writeBand(ImageStream &image, const unsigned char band[], int rowCount)
+    {
+        for (int y = rowCount - 1; y >= 0 && image.rowsWritten < image.height; --y)
+        {
+            const unsigned char *pixels = band + size_t(y) * image.width * 3;
+            if (image.isPNG)
+            {
+                writePNGRow(image, pixels);
+            }
+            else
+            {
+                fwrite(pixels, 1, size_t(image.width) * 3, image.file);
+            }
+            ++image.rowsWritten;
+        }
+        return !ferror(image.file);
+    }
+
+    bool endImage(ImageStream &image)
+    {
+        if (image.isPNG)
+        {
+            writeChunk(image.file, "IEND", {});
+        }
+        bool wasWritten = !ferror(image.file) && image.rowsWritten == image.height;
+        wasWritten = (fclose(image.file) == 0) && wasWritten;
+        image.file = nullptr;
+        return wasWritten;
+    }
+
+    bool writeImage(const std::string &path, const unsigned char RGBarray[], int width, int height)
+    {
+        ImageStream image;
+        if (!beginImage(image, path, width, height))
+        {
+            return false;
+        }
+        writeBand(image, RGBarray, height);
+        return endImage(image);
+    }
+}
@@ -0,0 +1,77 @@
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <mandelbrot_kernel.h>
+#include <algorithm>
+#include <cmath>
+#include <immintrin.h>
+
+#pragma GCC target("avx2") // everything below this line is compiled for AVX2
+#include <mandelbrot_kernel_simd.h>
+
+namespace
+{
+    struct Avx2DoubleOps
+    {
+        using scalar = double;
+        using reg = __m256d;
+        using mask = __m256d; // all ones / all zeros per lane
+        static constexpr int lanes = 4;
+
+        static reg load(const double *p) { return _mm256_loadu_pd(p); }
+        static void store(double *p, reg a) { _mm256_storeu_pd(p, a); }
+        static reg set1(double a) { return _mm256_set1_pd(a); }
+        static reg add(reg a, reg b) { return _mm256_add_pd(a, b); }
+        static reg sub(reg a, reg b) { return _mm256_sub_pd(a, b); }
+        static reg mul(reg a, reg b) { return _mm256_mul_pd(a, b); }
+        static mask greaterThan(reg a, reg b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+        static mask andMask(mask a, mask b) { return _mm256_and_pd(a, b); }
+        static mask andNotMask(mask a, mask b) { return _mm256_andnot_pd(a, b); }
+        static reg select(mask m, reg ifTrue, reg ifFalse) { return _mm256_blendv_pd(ifFalse, ifTrue, m); }
+        static bool none(mask m) { return _mm256_movemask_pd(m) == 0; }
+    };
+
+    struct Avx2FloatOps
+    {
+        using scalar = float;
+        using reg = __m256;
+        using mask = __m256;
+        static constexpr int lanes = 8;
+
+        static reg load(const float *p) { return _mm256_loadu_ps(p); }
+        static void store(float *p, reg a) { _mm256_storeu_ps(p, a); }
+        static reg set1(float a) { return _mm256_set1_ps(a); }
+        static reg add(reg a, reg b) { return _mm256_add_ps(a, b); }
+        static reg sub(reg a, reg b) { return _mm256_sub_ps(a, b); }
+        static reg mul(reg a, reg b) { return _mm256_mul_ps(a, b); }
+        static mask greaterThan(reg a, reg b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+        static mask andMask(mask a, mask b) { return _mm256_and_ps(a, b); }
+        static mask andNotMask(mask a, mask b) { return _mm256_andnot_ps(a, b); }
+        static reg select(mask m, reg ifTrue, reg ifFalse) { return _mm256_blendv_ps(ifFalse, ifTrue, m); }
+        static bool none(mask m) { return _mm256_movemask_ps(m) == 0; }
+    };
+}
+
+namespace kernelVariants
+{
+    void escapeTimeAVX2(const double cr[], const double ci[], float out[], int count)
+    {
+        escapeTimeBatchAnyCount<Avx2DoubleOps>(cr, ci, out, count);
+    }
+
+    void escapeTimeAVX2(const float cr[], const float ci[], float out[], int count)
+    {
+        escapeTimeBatchAnyCount<Avx2FloatOps>(cr, ci, out, count);
+    }
+
+    void paletteLookupAVX2(const palette::Palette &palette, unsigned char RGBarray[], const float iterationCounts[], int count)
+    {
+        paletteLookup<Avx2FloatOps>(palette, RGBarray, iterationCounts, count);
+    }
+
+    void hsvToRGBAVX2(const float h[], const float s[], const float v[], unsigned char out[], int count, int channels, unsigned char alpha)
+    {
+        hsvToRGB<Avx2FloatOps>(h, s, v, out, count, channels, alpha);
+    }
+}
+
+#endif
@@ -0,0 +1,78 @@
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <mandelbrot_kernel.h>
+#include <algorithm>
+#include <cmath>
+#include <immintrin.h>
+
+#pragma GCC target("avx512f") // everything below this line is compiled for AVX-512
+#pragma GCC optimize("fp-contract=off") // avx512f brings FMA, which would make results differ from the scalar kernel
+#include <mandelbrot_kernel_simd.h>
+
+namespace
+{
+    struct Avx512DoubleOps
+    {
+        using scalar = double;
+        using reg = __m512d;
+        using mask = __mmask8;
+        static constexpr int lanes = 8;
+
+        static reg load(const double *p) { return _mm512_loadu_pd(p); }
+        static void store(double *p, reg a) { _mm512_storeu_pd(p, a); }
+        static reg set1(double a) { return _mm512_set1_pd(a); }
+        static reg add(reg a, reg b) { return _mm512_add_pd(a, b); }
+        static reg sub(reg a, reg b) { return _mm512_sub_pd(a, b); }
+        static reg mul(reg a, reg b) { return _mm512_mul_pd(a, b); }
+        static mask greaterThan(reg a, reg b) { return _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ); }
+        static mask andMask(mask a, mask b) { return a & b; }
+        static mask andNotMask(mask a, mask b) { return ~a & b; }
+        static reg select(mask m, reg ifTrue, reg ifFalse) { return _mm512_mask_blend_pd(m, ifFalse, ifTrue); }
+        static bool none(mask m) { return m == 0; }
+    };
+
+    struct Avx512FloatOps
+    {
+        using scalar = float;
+        using reg = __m512;
+        using mask = __mmask16;
+        static constexpr int lanes = 16;
+
+        static reg load(const float *p) { return _mm512_loadu_ps(p); }
+        static void store(float *p, reg a) { _mm512_storeu_ps(p, a); }
+        static reg set1(float a) { return _mm512_set1_ps(a); }
+        static reg add(reg a, reg b) { return _mm512_add_ps(a, b); }
+        static reg sub(reg a, reg b) { return _mm512_sub_ps(a, b); }
+        static reg mul(reg a, reg b) { return _mm512_mul_ps(a, b); }
+        static mask greaterThan(reg a, reg b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+        static mask andMask(mask a, mask b) { return a & b; }
+        static mask andNotMask(mask a, mask b) { return ~a & b; }
+        static reg select(mask m, reg ifTrue, reg ifFalse) { return _mm512_mask_blend_ps(m, ifFalse, ifTrue); }
+        static bool none(mask m) { return m == 0; }
+    };
+}
+
+namespace kernelVariants
+{
+    void escapeTimeAVX512(const double cr[], const double ci[], float out[], int count)
+    {
+        escapeTimeBatchAnyCount<Avx512DoubleOps>(cr, ci, out, count);
+    }
+
+    void escapeTimeAVX512(const float cr[], const float ci[], float out[], int count)
+    {
+        escapeTimeBatchAnyCount<Avx512FloatOps>(cr, ci, out, count);
+    }
+
+    void paletteLookupAVX512(const palette::Palette &palette, unsigned char RGBarray[], const float iterationCounts[], int count)
+    {
+        paletteLookup<Avx512FloatOps>(palette, RGBarray, iterationCounts, count);
+    }
+
+    void hsvToRGBAVX512(const float h[], const float s[], const float v[], unsigned char out[], int count, int channels, unsigned char alpha)
+    {
+        hsvToRGB<Avx512FloatOps>(h, s, v, out, count, channels, alpha);
+    }
+}
+
+#endif
@@ -0,0 +1,108 @@
+#include <mandelbrot_kernel.h>
+#include <mandelbrot_kernel_simd.h>
+
+int max_iterations = 1000;
+double periodicityToleranceSquared = 1e-24;
+
+namespace kernelVariants
+{
+    void escapeTimeScalar(const double cr[], const double ci[], float out[], int count)
+    {
+        escapeTimeBatchAnyCount<ScalarOps<double>>(cr, ci, out, count);
+    }
+
+    void escapeTimeScalar(const float cr[], const float ci[], float out[], int count)
+    {
+        escapeTimeBatchAnyCount<ScalarOps<float>>(cr, ci, out, count);
+    }
+
+    void paletteLookupScalar(const palette::Palette &palette, unsigned char RGBarray[], const float iterationCounts[], int count)
+    {
+        paletteLookup<ScalarOps<float>>(palette, RGBarray, iterationCounts, count);
+    }
+
+    void hsvToRGBScalar(const float h[], const float s[], const float v[], unsigned char out[], int count, int channels, unsigned char alpha)
+    {
+        hsvToRGB<ScalarOps<float>>(h, s, v, out, count, channels, alpha);
+    }
+}
+
+namespace kernelDispatch
+{
+    using escapeTimeDoubleFunction = void (*)(const double[], const double[], float[], int);
+    using escapeTimeFloatFunction = void (*)(const float[], const float[], float[], int);
+    using paletteLookupFunction = void (*)(const palette::Palette &, unsigned char[], const float[], int);
+    using hsvToRGBFunction = void (*)(const float[], const float[], const float[], unsigned char[], int, int, unsigned char);
+
+    struct KernelTable
+    {
+        escapeTimeDoubleFunction escapeTimeDouble;
+        escapeTimeFloatFunction escapeTimeFloat;
+        paletteLookupFunction paletteLookup;
+        hsvToRGBFunction hsvToRGB;
+        const char *name;
+    };
+
+    // picks the widest variant this CPU (and OS, for the AVX register state) supports
+    KernelTable selectKernelsForThisCPU()
+    {
+        using namespace kernelVariants;
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_cpu_init(); // we run before main, so cpu detection may not be initialized yet
+
+        if (__builtin_cpu_supports("avx512f"))
+        {
+            return {escapeTimeAVX512, escapeTimeAVX512, paletteLookupAVX512, hsvToRGBAVX512, "AVX-512"};
+        }
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return {escapeTimeAVX2, escapeTimeAVX2, paletteLookupAVX2, hsvToRGBAVX2, "AVX2"};
+        }
+        if (__builtin_cpu_supports("sse2"))
+        {
+            return {escapeTimeSSE2, escapeTimeSSE2, paletteLookupSSE2, hsvToRGBSSE2, "SSE2"};
+        }
+#endif
+        return {escapeTimeScalar, escapeTimeScalar, paletteLookupScalar, hsvToRGBScalar, "scalar"};
+    }
+
+    // a function local static and not a global, palettes get built by global initializers in
+    // other files (main.cpp, coloringState), which may run before a global here would be set
+    const KernelTable &kernels()
+    {
+        static const KernelTable table = selectKernelsForThisCPU();
+        return table;
+    }
+}
+
+void smooth_iteration_count_batch(const double cr[], const double ci[], float out[], int count)
+{
+    kernelDispatch::kernels().escapeTimeDouble(cr, ci, out, count);
+}
+
+void smooth_iteration_count_batch(const float cr[], const float ci[], float out[], int count)
+{
+    kernelDispatch::kernels().escapeTimeFloat(cr, ci, out, count);
+}
+
+void palette::colorIterationCounts(const Palette &palette, unsigned char RGBarray[], const float iterationCounts[], int count)
+{
+    kernelDispatch::kernels().paletteLookup(palette, RGBarray, iterationCounts, count);
+}
+
+static_assert(sizeof(RGB) == 3 && sizeof(RGBA) == 4, "the batch conversion writes colors as packed bytes");
+
+void HSVtoRGBBatch(const float h[], const float s[], const float v[], RGB out[], int count)
+{
+    kernelDispatch::kernels().hsvToRGB(h, s, v, reinterpret_cast<unsigned char *>(out), count, 3, 255);
+}
+
+void HSVtoRGBABatch(const float h[], const float s[], const float v[], RGBA out[], int count, unsigned char alpha)
+{
+    kernelDispatch::kernels().hsvToRGB(h, s, v, reinterpret_cast<unsigned char *>(out), count, 4, alpha);
+}
+
+const char *kernelInstructionSetName()
+{
+    return kernelDispatch::kernels().name;
+}
@@ -0,0 +1,77 @@
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <mandelbrot_kernel.h>
+#include <algorithm>
+#include <cmath>
+#include <immintrin.h>
+
+#pragma GCC target("sse2") // everything below this line is compiled for SSE2
+#include <mandelbrot_kernel_simd.h>
+
+namespace
+{
+    struct Sse2DoubleOps
+    {
+        using scalar = double;
+        using reg = __m128d;
+        using mask = __m128d; // all ones / all zeros per lane
+        static constexpr int lanes = 2;
+
+        static reg load(const double *p) { return _mm_loadu_pd(p); }
+        static void store(double *p, reg a) { _mm_storeu_pd(p, a); }
+        static reg set1(double a) { return _mm_set1_pd(a); }
+        static reg add(reg a, reg b) { return _mm_add_pd(a, b); }
+        static reg sub(reg a, reg b) { return _mm_sub_pd(a, b); }
+        static reg mul(reg a, reg b) { return _mm_mul_pd(a, b); }
+        static mask greaterThan(reg a, reg b) { return _mm_cmpgt_pd(a, b); }
+        static mask andMask(mask a, mask b) { return _mm_and_pd(a, b); }
+        static mask andNotMask(mask a, mask b) { return _mm_andnot_pd(a, b); }
+        static reg select(mask m, reg ifTrue, reg ifFalse) { return _mm_or_pd(_mm_and_pd(m, ifTrue), _mm_andnot_pd(m, ifFalse)); } // no blendv before SSE4.1
+        static bool none(mask m) { return _mm_movemask_pd(m) == 0; }
+    };
+
+    struct Sse2FloatOps
+    {
+        using scalar = float;
+        using reg = __m128;
+        using mask = __m128;
+        static constexpr int lanes = 4;
+
+        static reg load(const float *p) { return _mm_loadu_ps(p); }
+        static void store(float *p, reg a) { _mm_storeu_ps(p, a); }
+        static reg set1(float a) { return _mm_set1_ps(a); }
+        static reg add(reg a, reg b) { return _mm_add_ps(a, b); }
+        static reg sub(reg a, reg b) { return _mm_sub_ps(a, b); }
+        static reg mul(reg a, reg b) { return _mm_mul_ps(a, b); }
+        static mask greaterThan(reg a, reg b) { return _mm_cmpgt_ps(a, b); }
+        static mask andMask(mask a, mask b) { return _mm_and_ps(a, b); }
+        static mask andNotMask(mask a, mask b) { return _mm_andnot_ps(a, b); }
+        static reg select(mask m, reg ifTrue, reg ifFalse) { return _mm_or_ps(_mm_and_ps(m, ifTrue), _mm_andnot_ps(m, ifFalse)); }
+        static bool none(mask m) { return _mm_movemask_ps(m) == 0; }
+    };
+}
+
+namespace kernelVariants
+{
+    void escapeTimeSSE2(const double cr[], const double ci[], float out[], int count)
+    {
+        escapeTimeBatchAnyCount<Sse2DoubleOps>(cr, ci, out, count);
+    }
+
+    void escapeTimeSSE2(const float cr[], const float ci[], float out[], int count)
+    {
+        escapeTimeBatchAnyCount<Sse2FloatOps>(cr, ci, out, count);
+    }
+
+    void paletteLookupSSE2(const palette::Palette &palette, unsigned char RGBarray[], const float iterationCounts[], int count)
+    {
+        paletteLookup<Sse2FloatOps>(palette, RGBarray, iterationCounts, count);
+    }
+
+    void hsvToRGBSSE2(const float h[], const float s[], const float v[], unsigned char out[], int count, int channels, unsigned char alpha)
+    {
+        hsvToRGB<Sse2FloatOps>(h, s, v, out, count, channels, alpha);
+    }
+}
+
+#endif
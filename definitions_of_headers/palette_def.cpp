@@ -0,0 +1,41 @@
+#include <palette.h>
+#include <cmath>
+
+namespace palette
+{
+    Palette makeHuePalette(float hueScale, float hueOffset)
+    {
+        Palette palette;
+
+        float hue[paletteSize + 1];
+        float saturation[paletteSize + 1];
+        float value[paletteSize + 1];
+        for (int k = 0; k <= paletteSize; ++k)
+        {
+            hue[k] = 360.0f * (k % paletteSize) / paletteSize;
+            saturation[k] = 1;
+            value[k] = 1;
+        }
+        RGB colors[paletteSize + 1];
+        HSVtoRGBBatch(hue, saturation, value, colors, paletteSize + 1);
+
+        for (int k = 0; k <= paletteSize; ++k)
+        {
+            RGB color = colors[k];
+            palette.r[k] = color.r;
+            palette.g[k] = color.g;
+            palette.b[k] = color.b;
+        }
+
+        palette.cyclesPerIteration = hueScale / 360;
+        palette.cycleOffset = 0;
+        shiftHue(palette, hueOffset);
+        return palette;
+    }
+
+    void shiftHue(Palette &palette, float degrees)
+    {
+        float offset = palette.cycleOffset + degrees / 360;
+        palette.cycleOffset = offset - std::floor(offset);
+    }
+}
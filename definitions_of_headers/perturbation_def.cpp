@@ -0,0 +1,162 @@
+#include <perturbation.h>
+#include <mandelbrot_kernel.h>
+#include <cmath>
+#include <algorithm>
+
+namespace perturbation
+{
+    ReferenceOrbit computeReferenceOrbit(const BigComplex &center, int fractionalLimbs, const std::atomic<bool> &shouldStop)
+    {
+        ReferenceOrbit orbit;
+        orbit.center = center;
+        orbit.fractionalLimbs = fractionalLimbs;
+        orbit.maxIterations = max_iterations;
+        orbit.zr.reserve(max_iterations + 1);
+        orbit.zi.reserve(max_iterations + 1);
+
+        BigFixed zr = bigFixedFromDouble(0, fractionalLimbs);
+        BigFixed zi = bigFixedFromDouble(0, fractionalLimbs);
+        orbit.zr.push_back(0);
+        orbit.zi.push_back(0);
+
+        for (int i = 0; i < max_iterations && !shouldStop.load(std::memory_order_relaxed); i++)
+        {
+            // z = z^2 + c
+            BigFixed tempZI = (zr + zr) * zi + center.i;
+            zr = zr * zr - zi * zi + center.r;
+            zi = tempZI;
+
+            double zrRounded = bigFixedToDouble(zr);
+            double ziRounded = bigFixedToDouble(zi);
+            orbit.zr.push_back(zrRounded);
+            orbit.zi.push_back(ziRounded);
+
+            if (zrRounded * zrRounded + ziRounded * ziRounded > bailoutRadius * bailoutRadius)
+            {
+                break;
+            }
+        }
+
+        return orbit;
+    }
+
+    // how small dz^2 has to be next to 2 Z dz to drop it
+    constexpr double bilinearApproximationEpsilon = 1.0 / (1 << 24);
+
+    BilinearApproximationTable buildBilinearApproximationTable(const ReferenceOrbit &orbit, double maxDcMagnitude)
+    {
+        BilinearApproximationTable table;
+        const int orbitLength = int(orbit.zr.size());
+
+        // one step from m to m + 1: dz -> 2 Z_m dz + dc, for m = 1 ... orbitLength - 2
+        std::vector<BilinearApproximation> singleSteps;
+        for (int m = 1; m + 1 < orbitLength; ++m)
+        {
+            double ar = 2 * orbit.zr[m];
+            double ai = 2 * orbit.zi[m];
+            singleSteps.push_back({ar, ai, 1, 0, bilinearApproximationEpsilon * std::hypot(ar, ai)});
+        }
+        table.levels.push_back(std::move(singleSteps));
+
+        // x then y: A = Ay Ax, B = Ay Bx + By, and dz must stay valid for y after going through x
+        while (table.levels.back().size() >= 2)
+        {
+            const std::vector<BilinearApproximation> &previous = table.levels.back();
+            std::vector<BilinearApproximation> merged;
+            for (size_t j = 0; j + 1 < previous.size(); j += 2)
+            {
+                const BilinearApproximation &x = previous[j];
+                const BilinearApproximation &y = previous[j + 1];
+
+                BilinearApproximation z;
+                z.ar = y.ar * x.ar - y.ai * x.ai;
+                z.ai = y.ar * x.ai + y.ai * x.ar;
+                z.br = y.ar * x.br - y.ai * x.bi + y.br;
+                z.bi = y.ar * x.bi + y.ai * x.br + y.bi;
+
+                double absoluteAx = std::hypot(x.ar, x.ai);
+                double radiusThroughX = absoluteAx == 0 ? 0 : (y.validRadius - std::hypot(x.br, x.bi) * maxDcMagnitude) / absoluteAx;
+                z.validRadius = std::max(0.0, std::min(x.validRadius, radiusThroughX));
+                merged.push_back(z);
+            }
+            table.levels.push_back(std::move(merged));
+        }
+
+        return table;
+    }
+
+    float perturbedSmoothIterationCount(const ReferenceOrbit &orbit, const BilinearApproximationTable &table, double dcr, double dci)
+    {
+        const double *Zr = orbit.zr.data();
+        const double *Zi = orbit.zi.data();
+        const int orbitLength = int(orbit.zr.size());
+        const int levelCount = int(table.levels.size());
+
+        double dzr = 0;
+        double dzi = 0;
+        int n = 0; // position in the reference orbit
+
+        for (int i = 0; i < max_iterations; i++)
+        {
+            // take the longest approximated step that is valid here and doesn't overshoot max_iterations.
+            // Steps of length 2^k start at n = 1 + j 2^k
+            const BilinearApproximation *step = nullptr;
+            int stepLength = 1;
+            if (n >= 1)
+            {
+                double absoluteDZsquared = dzr * dzr + dzi * dzi;
+                for (int k = 0; k < levelCount && ((n - 1) & ((1 << k) - 1)) == 0 && i + (1 << k) <= max_iterations; ++k)
+                {
+                    int j = (n - 1) >> k;
+                    if (j >= int(table.levels[k].size()))
+                    {
+                        break;
+                    }
+                    const BilinearApproximation &candidate = table.levels[k][j];
+                    if (absoluteDZsquared >= candidate.validRadius * candidate.validRadius)
+                    {
+                        break;
+                    }
+                    step = &candidate;
+                    stepLength = 1 << k;
+                }
+            }
+
+            if (step != nullptr)
+            {
+                double tempDZI = step->ar * dzi + step->ai * dzr + step->br * dci + step->bi * dcr;
+                dzr = step->ar * dzr - step->ai * dzi + step->br * dcr - step->bi * dci;
+                dzi = tempDZI;
+                n += stepLength;
+                i += stepLength - 1;
+            }
+            else
+            {
+                // dz = 2 Z dz + dz^2 + dc
+                double tempDZI = 2 * (Zr[n] * dzi + Zi[n] * dzr) + 2 * dzr * dzi + dci;
+                dzr = 2 * (Zr[n] * dzr - Zi[n] * dzi) + dzr * dzr - dzi * dzi + dcr;
+                dzi = tempDZI;
+                ++n;
+            }
+
+            double zr = Zr[n] + dzr;
+            double zi = Zi[n] + dzi;
+
+            double absoluteZsquared = zr * zr + zi * zi;
+            if (absoluteZsquared > bailoutRadius * bailoutRadius)
+            {
+                double smoother = 2.0 - log2(log(absoluteZsquared));
+                return i + smoother;
+            }
+
+            if (absoluteZsquared < dzr * dzr + dzi * dzi || n == orbitLength - 1)
+            {
+                dzr = zr;
+                dzi = zi;
+                n = 0;
+            }
+        }
+
+        return is_in_mandelbrot_set;
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <double_double.h>
+
+// Fixed point number with as many fractional bits as needed, for the deep zoom center and reference
+// orbit. limbs[0] is the integer part and limbs[k] holds the bits of weight 2^(-32k) to 2^(-32k-31).
+// Magnitude and sign are stored separately
+struct BigFixed
+{
+    bool isNegative = false;
+    std::vector<uint32_t> limbs{0};
+};
+
+struct BigComplex
+{
+    BigFixed r;
+    BigFixed i;
+};
+
+// enough fractional limbs to place a pixel of a view this wide with full double precision
+int fractionalLimbsForZoom(double zoom);
+
+BigFixed bigFixedFromDouble(double value, int fractionalLimbs);
+// plain decimal notation ("-0.7436438870371587047521915"), so a center can carry more digits than a
+// double has. False when it isn't a number, or its integer part doesn't fit in 32 bits
+bool bigFixedFromString(const std::string &decimal, int fractionalLimbs, BigFixed &result);
+double bigFixedToDouble(const BigFixed &a);
+DoubleDouble bigFixedToDoubleDouble(const BigFixed &a);
+QuadDouble bigFixedToQuadDouble(const BigFixed &a);
+
+// results have as many fractional limbs as the longer operand, multiplication truncates
+BigFixed operator+(const BigFixed &a, const BigFixed &b);
+BigFixed operator-(const BigFixed &a, const BigFixed &b);
+BigFixed operator*(const BigFixed &a, const BigFixed &b);
@@ -13,4 +13,17 @@ struct HSV {
     float v; // value(brightness) [0, 1]
 };
 
-RGB HSVtoRGB(HSV hsv);
\ No newline at end of file
+struct RGBA {
+    unsigned char r;
+    unsigned char g;
+    unsigned char b;
+    unsigned char a;
+};
+
+RGB HSVtoRGB(HSV hsv);
+
+// converts count colors given as separate h, s and v arrays, several per instruction. The
+// variant is picked at startup like the escape time kernel (mandelbrot_kernel_def.cpp). Same
+// result as HSVtoRGB give or take 1 per channel, except that the hue gets wrapped into [0, 360)
+void HSVtoRGBBatch(const float h[], const float s[], const float v[], RGB out[], int count);
+void HSVtoRGBABatch(const float h[], const float s[], const float v[], RGBA out[], int count, unsigned char alpha = 255);
\ No newline at end of file
@@ -0,0 +1,253 @@
+#pragma once
+
+#include <cmath>
+
+// Software extended precision made of unevaluated sums of doubles: DoubleDouble has ~106 bits of
+// mantissa, QuadDouble ~212. Both are drop-in numeric types for the templated kernel
+// (smooth_iteration_count<T>), so views between ~1e-13 and ~1e-60 can be iterated directly without
+// a general arbitrary precision library. Algorithms follow Hida, Li and Bailey's QD library.
+// Everything is inline because it sits in the innermost loop
+
+namespace extendedPrecision
+{
+    // s + err == a + b exactly
+    inline double twoSum(double a, double b, double &err)
+    {
+        double s = a + b;
+        double bb = s - a;
+        err = (a - (s - bb)) + (b - bb);
+        return s;
+    }
+
+    // same, but only when |a| >= |b|
+    inline double quickTwoSum(double a, double b, double &err)
+    {
+        double s = a + b;
+        err = b - (s - a);
+        return s;
+    }
+
+    // p + err == a * b exactly
+    inline double twoProd(double a, double b, double &err)
+    {
+        double p = a * b;
+#if defined(__FMA__)
+        err = std::fma(a, b, -p);
+#else
+        // Dekker's product, since std::fma is a slow library call without FMA hardware
+        constexpr double splitter = 134217729.0; // 2^27 + 1
+        double ta = splitter * a;
+        double aHi = ta - (ta - a);
+        double aLo = a - aHi;
+        double tb = splitter * b;
+        double bHi = tb - (tb - b);
+        double bLo = b - bHi;
+        err = ((aHi * bHi - p) + aHi * bLo + aLo * bHi) + aLo * bLo;
+#endif
+        return p;
+    }
+
+    inline void threeSum(double &a, double &b, double &c)
+    {
+        double t1, t2, t3;
+        t1 = twoSum(a, b, t2);
+        a = twoSum(c, t1, t3);
+        b = twoSum(t2, t3, c);
+    }
+
+    inline void threeSum2(double &a, double &b, double &c)
+    {
+        double t1, t2, t3;
+        t1 = twoSum(a, b, t2);
+        a = twoSum(c, t1, t3);
+        b = t2 + t3;
+    }
+
+    // turns the overlapping c0 + ... + c4 into four non overlapping components c0 ... c3
+    inline void renormalize(double &c0, double &c1, double &c2, double &c3, double c4)
+    {
+        double s0, s1, s2 = 0, s3 = 0;
+
+        s0 = quickTwoSum(c3, c4, c4);
+        s0 = quickTwoSum(c2, s0, c3);
+        s0 = quickTwoSum(c1, s0, c2);
+        c0 = quickTwoSum(c0, s0, c1);
+
+        s0 = c0;
+        s1 = c1;
+        if (s1 != 0)
+        {
+            s1 = quickTwoSum(s1, c2, s2);
+            if (s2 != 0)
+            {
+                s2 = quickTwoSum(s2, c3, s3);
+                if (s3 != 0)
+                    s3 += c4;
+                else
+                    s2 = quickTwoSum(s2, c4, s3);
+            }
+            else
+            {
+                s1 = quickTwoSum(s1, c3, s2);
+                if (s2 != 0)
+                    s2 = quickTwoSum(s2, c4, s3);
+                else
+                    s1 = quickTwoSum(s1, c4, s2);
+            }
+        }
+        else
+        {
+            s0 = quickTwoSum(s0, c2, s1);
+            if (s1 != 0)
+            {
+                s1 = quickTwoSum(s1, c3, s2);
+                if (s2 != 0)
+                    s2 = quickTwoSum(s2, c4, s3);
+                else
+                    s1 = quickTwoSum(s1, c4, s2);
+            }
+            else
+            {
+                s0 = quickTwoSum(s0, c3, s1);
+                if (s1 != 0)
+                    s1 = quickTwoSum(s1, c4, s2);
+                else
+                    s0 = quickTwoSum(s0, c4, s1);
+            }
+        }
+
+        c0 = s0;
+        c1 = s1;
+        c2 = s2;
+        c3 = s3;
+    }
+}
+
+struct DoubleDouble
+{
+    double hi;
+    double lo;
+
+    DoubleDouble(double value = 0) : hi(value), lo(0) {}
+    DoubleDouble(double hi_, double lo_) : hi(hi_), lo(lo_) {}
+
+    explicit operator double() const { return hi + lo; }
+};
+
+inline DoubleDouble operator+(const DoubleDouble &a, const DoubleDouble &b)
+{
+    using namespace extendedPrecision;
+    double e, f;
+    double s = twoSum(a.hi, b.hi, e);
+    double t = twoSum(a.lo, b.lo, f);
+    e += t;
+    s = quickTwoSum(s, e, e);
+    e += f;
+    s = quickTwoSum(s, e, e);
+    return {s, e};
+}
+
+inline DoubleDouble operator-(const DoubleDouble &a)
+{
+    return {-a.hi, -a.lo};
+}
+
+inline DoubleDouble operator-(const DoubleDouble &a, const DoubleDouble &b)
+{
+    return a + -b;
+}
+
+inline DoubleDouble operator*(const DoubleDouble &a, const DoubleDouble &b)
+{
+    using namespace extendedPrecision;
+    double e;
+    double p = twoProd(a.hi, b.hi, e);
+    e += a.hi * b.lo + a.lo * b.hi;
+    p = quickTwoSum(p, e, e);
+    return {p, e};
+}
+
+inline bool operator>(const DoubleDouble &a, const DoubleDouble &b)
+{
+    return a.hi > b.hi || (a.hi == b.hi && a.lo > b.lo);
+}
+
+struct QuadDouble
+{
+    double x[4];
+
+    QuadDouble(double value = 0) : x{value, 0, 0, 0} {}
+    QuadDouble(double x0, double x1, double x2, double x3) : x{x0, x1, x2, x3} {}
+
+    explicit operator double() const { return x[0] + x[1]; }
+};
+
+inline QuadDouble operator+(const QuadDouble &a, const QuadDouble &b)
+{
+    using namespace extendedPrecision;
+    double t0, t1, t2, t3;
+    double s0 = twoSum(a.x[0], b.x[0], t0);
+    double s1 = twoSum(a.x[1], b.x[1], t1);
+    double s2 = twoSum(a.x[2], b.x[2], t2);
+    double s3 = twoSum(a.x[3], b.x[3], t3);
+
+    s1 = twoSum(s1, t0, t0);
+    threeSum(s2, t0, t1);
+    threeSum2(s3, t0, t2);
+    t0 = t0 + t1 + t3;
+
+    renormalize(s0, s1, s2, s3, t0);
+    return {s0, s1, s2, s3};
+}
+
+inline QuadDouble operator-(const QuadDouble &a)
+{
+    return {-a.x[0], -a.x[1], -a.x[2], -a.x[3]};
+}
+
+inline QuadDouble operator-(const QuadDouble &a, const QuadDouble &b)
+{
+    return a + -b;
+}
+
+inline QuadDouble operator*(const QuadDouble &a, const QuadDouble &b)
+{
+    using namespace extendedPrecision;
+    double q0, q1, q2, q3, q4, q5;
+    double p0 = twoProd(a.x[0], b.x[0], q0);
+    double p1 = twoProd(a.x[0], b.x[1], q1);
+    double p2 = twoProd(a.x[1], b.x[0], q2);
+    double p3 = twoProd(a.x[0], b.x[2], q3);
+    double p4 = twoProd(a.x[1], b.x[1], q4);
+    double p5 = twoProd(a.x[2], b.x[0], q5);
+
+    threeSum(p1, p2, q0);
+
+    // (s0, s1, s2) = (p2, q1, q2) + (p3, p4, p5)
+    threeSum(p2, q1, q2);
+    threeSum(p3, p4, p5);
+    double t0, t1;
+    double s0 = twoSum(p2, p3, t0);
+    double s1 = twoSum(q1, p4, t1);
+    double s2 = q2 + p5;
+    s1 = twoSum(s1, t0, t0);
+    s2 += (t0 + t1);
+
+    // terms of order eps^3
+    s1 += a.x[0] * b.x[3] + a.x[1] * b.x[2] + a.x[2] * b.x[1] + a.x[3] * b.x[0] + q0 + q3 + q4 + q5;
+
+    renormalize(p0, p1, s0, s1, s2);
+    return {p0, p1, s0, s1};
+}
+
+inline bool operator>(const QuadDouble &a, const QuadDouble &b)
+{
+    for (int k = 0; k < 4; ++k)
+    {
+        if (a.x[k] != b.x[k])
+        {
+            return a.x[k] > b.x[k];
+        }
+    }
+    return false;
+}
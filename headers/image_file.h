@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+#include <cstdio>
+#include <cstdint>
+
+// writes 8 bit RGB images as PPM, or PNG when the file name ends in .png. Pixel arrays hold their
+// rows bottom to top, the way the renders (and the GL texture) lay them out, and the file gets them
+// top to bottom. The PNG is uncompressed (stored deflate blocks), so it needs no zlib and is about as
+// big as the PPM. Everything returns false when the file can't be written
+namespace imageFile
+{
+    bool writeImage(const std::string &path, const unsigned char RGBarray[], int width, int height);
+
+    // for images too big to hold in memory: after beginImage the rows go to the file a band at a
+    // time with writeBand, from the top of the image down, and endImage finishes it
+    struct ImageStream
+    {
+        FILE *file = nullptr;
+        bool isPNG = false;
+        int width = 0;
+        int height = 0;
+        int rowsWritten = 0;
+        uint32_t adlerA = 1; // running zlib checksum over the PNG's rows
+        uint32_t adlerB = 0;
+    };
+
+    bool beginImage(ImageStream &image, const std::string &path, int width, int height);
+    // the next rowCount rows down the image, bottom to top within band like any other pixel array
+    bool writeBand(ImageStream &image, const unsigned char band[], int rowCount);
+    bool endImage(ImageStream &image);
+}
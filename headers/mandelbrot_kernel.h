@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cmath>
+#include <double_double.h>
+
+constexpr int bailoutRadius = 100;
+// how many iterations an orbit gets before it counts as inside the set. Set before every render
+// from the zoom and the previous frame (main.cpp, iterationBudget), and left alone while one runs
+extern int max_iterations;
+using precision = double;
+
+enum
+{
+    is_in_mandelbrot_set = -10,
+};
+
+// T is double, float, DoubleDouble or QuadDouble
+template <class T>
+struct basic_complex
+{
+    T r;
+    T i;
+};
+using complex = basic_complex<precision>;
+
+// closed form membership test for the main cardioid and the period-2 bulb, which cover most of
+// the set at the default view. Written only with + * > so the SIMD kernel can use the same formula
+template <class T>
+inline bool isOutsideMainCardioidAndPeriod2Bulb(T cr, T ci)
+{
+    T xMinusQuarter = cr - T(0.25);
+    T ciSquared = ci * ci;
+    T q = xMinusQuarter * xMinusQuarter + ciSquared;
+    bool outsideCardioid = q * (q + xMinusQuarter) > T(0.25) * ciSquared;
+
+    T xPlusOne = cr + T(1);
+    bool outsideBulb = xPlusOne * xPlusOne + ciSquared > T(0.0625);
+
+    return outsideCardioid && outsideBulb;
+}
+
+// Brent style cycle detection: z is compared against a saved orbit point, and the point is saved
+// again after 1, 2, 4, 8... iterations, so any cycle gets caught once the window outgrows its period.
+// An orbit that comes back closer than this (squared) is declared interior. Set before every render
+// with the number type (main.cpp, numericTier), from the pixel spacing and the type's rounding error
+extern double periodicityToleranceSquared;
+
+inline bool isTimeToSaveOrbitPoint(int i)
+{
+    return (i & (i + 1)) == 0; // i + 1 is a power of two
+}
+
+template <class T>
+inline float smooth_iteration_count(basic_complex<T> &c)
+{
+    if (!isOutsideMainCardioidAndPeriod2Bulb(c.r, c.i))
+    {
+        return is_in_mandelbrot_set;
+    }
+
+    basic_complex<T> z{0, 0};
+    basic_complex<T> saved{0, 0};
+
+    for (int i = 0; i < max_iterations; i++)
+    {
+        // z = z^2 + c
+        T tempZI = T(2) * z.r * z.i + c.i;
+        z.r = z.r * z.r - z.i * z.i + c.r;
+        z.i = tempZI;
+
+        T absoluteCsquared = z.r * z.r + z.i * z.i;
+        if (absoluteCsquared > T(bailoutRadius * bailoutRadius))
+        {
+            double smoother = 2.0 - log2(log(double(absoluteCsquared)));
+            return i + smoother;
+        }
+
+        T dr = z.r - saved.r;
+        T di = z.i - saved.i;
+        if (T(periodicityToleranceSquared) > dr * dr + di * di)
+        {
+            return is_in_mandelbrot_set;
+        }
+        if (isTimeToSaveOrbitPoint(i))
+        {
+            saved = z;
+        }
+    }
+
+    return is_in_mandelbrot_set;
+}
+template <class T>
+inline float smooth_iteration_count(basic_complex<T> &&c)
+{
+    return smooth_iteration_count(c);
+}
+
+// how many pixels the render paths hand to the batch kernel at once
+constexpr int kernelBatchSize = 64;
+
+// same result as smooth_iteration_count for every c = cr[k] + ci[k]i, but iterates several pixels
+// per instruction (AVX-512: 8 doubles/16 floats, AVX2: 4/8, SSE2: 2/4). The variant is picked once
+// at startup from what the CPU supports, so one binary runs at full speed everywhere
+void smooth_iteration_count_batch(const double cr[], const double ci[], float out[], int count);
+void smooth_iteration_count_batch(const float cr[], const float ci[], float out[], int count);
+
+// the extended precision types have no SIMD variant, they go one pixel at a time
+template <class T>
+void smooth_iteration_count_batch(const T cr[], const T ci[], float out[], int count)
+{
+    for (int k = 0; k < count; ++k)
+    {
+        out[k] = smooth_iteration_count(basic_complex<T>{cr[k], ci[k]});
+    }
+}
+
+const char *kernelInstructionSetName(); // "AVX-512", "AVX2", "SSE2" or "scalar"
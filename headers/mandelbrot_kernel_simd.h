@@ -0,0 +1,291 @@
+#pragma once
+
+// The escape time kernel written once against a tiny "Ops" interface. Each instruction set gets
+// its own definitions_of_headers/mandelbrot_kernel_<isa>_def.cpp that includes this file after a
+// `#pragma GCC target(...)` line, so the same code is compiled once per ISA inside a single g++
+// invocation. Ops structs live in anonymous namespaces there, so the instantiations never clash.
+//
+// Ops must provide: scalar, reg, mask, lanes, load, store, set1, add, sub, mul, greaterThan,
+// andMask, andNotMask (not a, and b), select, none.
+//
+// The palette lookup of palette::colorIterationCounts and the HSV conversion of HSVtoRGBBatch are
+// compiled the same way.
+
+#include <mandelbrot_kernel.h>
+#include <palette.h>
+#include <algorithm>
+#include <cmath>
+
+template <class T>
+struct ScalarOps
+{
+    using scalar = T;
+    using reg = T;
+    using mask = bool;
+    static constexpr int lanes = 1;
+
+    static reg load(const T *p) { return *p; }
+    static void store(T *p, reg a) { *p = a; }
+    static reg set1(T a) { return a; }
+    static reg add(reg a, reg b) { return a + b; }
+    static reg sub(reg a, reg b) { return a - b; }
+    static reg mul(reg a, reg b) { return a * b; }
+    static mask greaterThan(reg a, reg b) { return a > b; }
+    static mask andMask(mask a, mask b) { return a && b; }
+    static mask andNotMask(mask a, mask b) { return !a && b; }
+    static reg select(mask m, reg ifTrue, reg ifFalse) { return m ? ifTrue : ifFalse; }
+    static bool none(mask m) { return !m; }
+};
+
+// computes exactly Ops::lanes pixels. A lane that escapes records its iteration and |z|^2 and
+// is masked out; the batch stops as soon as no lane is active anymore
+template <class Ops>
+inline void escapeTimeBatch(const typename Ops::scalar cr[], const typename Ops::scalar ci[], float out[])
+{
+    using scalar = typename Ops::scalar;
+    using reg = typename Ops::reg;
+    using mask = typename Ops::mask;
+
+    const reg cR = Ops::load(cr);
+    const reg cI = Ops::load(ci);
+    const reg bailoutSquared = Ops::set1(bailoutRadius * bailoutRadius);
+
+    reg zR = Ops::set1(0);
+    reg zI = Ops::set1(0);
+    reg savedR = Ops::set1(0);
+    reg savedI = Ops::set1(0);
+    const reg toleranceSquared = Ops::set1(scalar(periodicityToleranceSquared));
+    reg escapedAt = Ops::set1(0);
+    reg escapedMagnitude = Ops::set1(0); // stays 0 for lanes that never escape
+
+    // lanes inside the main cardioid or the period-2 bulb start out inactive (same formula as
+    // isOutsideMainCardioidAndPeriod2Bulb)
+    const reg xMinusQuarter = Ops::sub(cR, Ops::set1(0.25));
+    const reg ciSquared = Ops::mul(cI, cI);
+    const reg q = Ops::add(Ops::mul(xMinusQuarter, xMinusQuarter), ciSquared);
+    const mask outsideCardioid = Ops::greaterThan(Ops::mul(q, Ops::add(q, xMinusQuarter)), Ops::mul(Ops::set1(0.25), ciSquared));
+    const reg xPlusOne = Ops::add(cR, Ops::set1(1));
+    const mask outsideBulb = Ops::greaterThan(Ops::add(Ops::mul(xPlusOne, xPlusOne), ciSquared), Ops::set1(0.0625));
+    mask active = Ops::andMask(outsideCardioid, outsideBulb);
+
+    for (int i = 0; i < max_iterations && !Ops::none(active); i++)
+    {
+        // z = z^2 + c
+        reg tempZI = Ops::add(Ops::mul(Ops::add(zR, zR), zI), cI);
+        zR = Ops::add(Ops::sub(Ops::mul(zR, zR), Ops::mul(zI, zI)), cR);
+        zI = tempZI;
+
+        reg absoluteCsquared = Ops::add(Ops::mul(zR, zR), Ops::mul(zI, zI));
+        mask escapedNow = Ops::andMask(Ops::greaterThan(absoluteCsquared, bailoutSquared), active);
+
+        escapedMagnitude = Ops::select(escapedNow, absoluteCsquared, escapedMagnitude);
+        escapedAt = Ops::select(escapedNow, Ops::set1(scalar(i)), escapedAt);
+        active = Ops::andNotMask(escapedNow, active);
+
+        // the save schedule only depends on i, so all lanes share it (see smooth_iteration_count)
+        reg dr = Ops::sub(zR, savedR);
+        reg di = Ops::sub(zI, savedI);
+        mask cycleFound = Ops::greaterThan(toleranceSquared, Ops::add(Ops::mul(dr, dr), Ops::mul(di, di)));
+        active = Ops::andNotMask(cycleFound, active);
+        if (isTimeToSaveOrbitPoint(i))
+        {
+            savedR = zR;
+            savedI = zI;
+        }
+    }
+
+    scalar iterations[Ops::lanes];
+    scalar magnitudes[Ops::lanes];
+    Ops::store(iterations, escapedAt);
+    Ops::store(magnitudes, escapedMagnitude);
+
+    for (int lane = 0; lane < Ops::lanes; ++lane)
+    {
+        if (magnitudes[lane] == 0)
+        {
+            out[lane] = is_in_mandelbrot_set;
+        }
+        else
+        {
+            double smoother = 2.0 - log2(log(double(magnitudes[lane])));
+            out[lane] = iterations[lane] + smoother;
+        }
+    }
+}
+
+template <class Ops>
+inline void escapeTimeBatchAnyCount(const typename Ops::scalar cr[], const typename Ops::scalar ci[], float out[], int count)
+{
+    using scalar = typename Ops::scalar;
+    constexpr int lanes = Ops::lanes;
+
+    int k = 0;
+    for (; k + lanes <= count; k += lanes)
+    {
+        escapeTimeBatch<Ops>(cr + k, ci + k, out + k);
+    }
+
+    if (k < count)
+    {
+        // pad the tail with a point that escapes on the first iteration
+        scalar tailR[lanes];
+        scalar tailI[lanes];
+        float tailOut[lanes];
+        for (int lane = 0; lane < lanes; ++lane)
+        {
+            bool isReal = k + lane < count;
+            tailR[lane] = isReal ? cr[k + lane] : scalar(2 * bailoutRadius);
+            tailI[lane] = isReal ? ci[k + lane] : scalar(0);
+        }
+        escapeTimeBatch<Ops>(tailR, tailI, tailOut);
+        for (int lane = 0; k + lane < count; ++lane)
+        {
+            out[k + lane] = tailOut[lane];
+        }
+    }
+}
+
+// how many pixels the palette lookup does per pass, small enough for its scratch arrays to stay in L1
+constexpr int paletteLookupBatchSize = 256;
+
+// colors count iteration counts through the palette (see palette::colorIterationCounts). Written
+// as plain loops without branches or calls that the compiler vectorizes for the target of the
+// file including this, Ops only keeps the instantiations of the different files apart
+template <class Ops>
+inline void paletteLookup(const palette::Palette &palette, unsigned char RGBarray[], const float iterationCounts[], int count)
+{
+    int index[paletteLookupBatchSize];
+    float weight[paletteLookupBatchSize];
+
+    for (int batchBegin = 0; batchBegin < count; batchBegin += paletteLookupBatchSize)
+    {
+        int batchCount = (count - batchBegin < paletteLookupBatchSize) ? count - batchBegin : paletteLookupBatchSize;
+        const float *iterations = iterationCounts + batchBegin;
+
+        // floor by hand, the SSE2 variant has no rounding instruction
+        for (int k = 0; k < batchCount; ++k)
+        {
+            float position = iterations[k] * palette.cyclesPerIteration + palette.cycleOffset;
+            int whole = int(position);
+            whole -= position < float(whole);
+            float sample = (position - float(whole)) * palette::paletteSize;
+            int sampleIndex = int(sample);
+            sampleIndex -= sampleIndex == palette::paletteSize; // a fraction just below 1 can round up to it
+            index[k] = sampleIndex;
+            weight[k] = sample - float(sampleIndex);
+        }
+
+        // the lookups go to separate arrays first, the interleaved byte stores would keep the
+        // compiler from vectorizing them
+        float r[paletteLookupBatchSize];
+        float g[paletteLookupBatchSize];
+        float b[paletteLookupBatchSize];
+        for (int k = 0; k < batchCount; ++k)
+        {
+            int i = index[k];
+            float w = weight[k];
+            bool isInside = iterations[k] == is_in_mandelbrot_set;
+            r[k] = isInside ? 0.0f : palette.r[i] + (palette.r[i + 1] - palette.r[i]) * w + 0.5f;
+            g[k] = isInside ? 0.0f : palette.g[i] + (palette.g[i + 1] - palette.g[i]) * w + 0.5f;
+            b[k] = isInside ? 0.0f : palette.b[i] + (palette.b[i + 1] - palette.b[i]) * w + 0.5f;
+        }
+
+        unsigned char *out = RGBarray + size_t(batchBegin) * 3;
+        for (int k = 0; k < batchCount; ++k)
+        {
+            out[k * 3 + 0] = (unsigned char)r[k];
+            out[k * 3 + 1] = (unsigned char)g[k];
+            out[k * 3 + 2] = (unsigned char)b[k];
+        }
+    }
+}
+
+// how many colors the HSV conversion does per pass, same reasoning as paletteLookupBatchSize
+constexpr int hsvConversionBatchSize = 256;
+
+// converts count HSV colors to bytes (see HSVtoRGBBatch), channels is 3 for RGB or 4 for RGBA
+// with alpha as the fourth byte. Plain loops like paletteLookup: every channel is the same
+// trapezoid over the hue, just shifted, so there is no branch on the hue sector
+template <class Ops>
+inline void hsvToRGB(const float h[], const float s[], const float v[], unsigned char out[], int count, int channels, unsigned char alpha)
+{
+    float sector[hsvConversionBatchSize];
+    float r[hsvConversionBatchSize];
+    float g[hsvConversionBatchSize];
+    float b[hsvConversionBatchSize];
+
+    for (int batchBegin = 0; batchBegin < count; batchBegin += hsvConversionBatchSize)
+    {
+        int batchCount = (count - batchBegin < hsvConversionBatchSize) ? count - batchBegin : hsvConversionBatchSize;
+        const float *hue = h + batchBegin;
+        const float *saturation = s + batchBegin;
+        const float *value = v + batchBegin;
+
+        // hue in sixths of a turn, wrapped into [0, 6) with the floor by hand of paletteLookup
+        for (int k = 0; k < batchCount; ++k)
+        {
+            float turns = hue[k] / 360;
+            int whole = int(turns);
+            whole -= turns < float(whole);
+            sector[k] = (turns - float(whole)) * 6;
+        }
+
+        // channel n (5 red, 3 green, 1 blue) is v - v*s*ramp, ramp being 0 up to 1 sixth past
+        // n + hue, 1 from 2 to 4 and 0 again from 5. It is 0 at both ends, so it does not matter
+        // on which side of 6 the wrap rounds
+        for (int k = 0; k < batchCount; ++k)
+        {
+            float chroma = value[k] * saturation[k];
+            float positionR = 5 + sector[k];
+            float positionG = 3 + sector[k];
+            float positionB = 1 + sector[k];
+            positionR -= 6 * float(int(positionR * (1.0f / 6)));
+            positionG -= 6 * float(int(positionG * (1.0f / 6)));
+            positionB -= 6 * float(int(positionB * (1.0f / 6)));
+            float rampR = std::max(0.0f, std::min(std::min(positionR, 4 - positionR), 1.0f));
+            float rampG = std::max(0.0f, std::min(std::min(positionG, 4 - positionG), 1.0f));
+            float rampB = std::max(0.0f, std::min(std::min(positionB, 4 - positionB), 1.0f));
+            r[k] = (value[k] - chroma * rampR) * 255 + 0.5f;
+            g[k] = (value[k] - chroma * rampG) * 255 + 0.5f;
+            b[k] = (value[k] - chroma * rampB) * 255 + 0.5f;
+        }
+
+        unsigned char *colors = out + size_t(batchBegin) * channels;
+        for (int k = 0; k < batchCount; ++k)
+        {
+            colors[k * channels + 0] = (unsigned char)r[k];
+            colors[k * channels + 1] = (unsigned char)g[k];
+            colors[k * channels + 2] = (unsigned char)b[k];
+        }
+        if (channels == 4)
+        {
+            for (int k = 0; k < batchCount; ++k)
+            {
+                colors[k * 4 + 3] = alpha;
+            }
+        }
+    }
+}
+
+// one entry point per ISA, defined in the matching mandelbrot_kernel_<isa>_def.cpp
+namespace kernelVariants
+{
+    void escapeTimeScalar(const double cr[], const double ci[], float out[], int count);
+    void escapeTimeScalar(const float cr[], const float ci[], float out[], int count);
+    void paletteLookupScalar(const palette::Palette &palette, unsigned char RGBarray[], const float iterationCounts[], int count);
+    void hsvToRGBScalar(const float h[], const float s[], const float v[], unsigned char out[], int count, int channels, unsigned char alpha);
+#if defined(__x86_64__) || defined(__i386__)
+    void escapeTimeSSE2(const double cr[], const double ci[], float out[], int count);
+    void escapeTimeSSE2(const float cr[], const float ci[], float out[], int count);
+    void paletteLookupSSE2(const palette::Palette &palette, unsigned char RGBarray[], const float iterationCounts[], int count);
+    void hsvToRGBSSE2(const float h[], const float s[], const float v[], unsigned char out[], int count, int channels, unsigned char alpha);
+    void escapeTimeAVX2(const double cr[], const double ci[], float out[], int count);
+    void escapeTimeAVX2(const float cr[], const float ci[], float out[], int count);
+    void paletteLookupAVX2(const palette::Palette &palette, unsigned char RGBarray[], const float iterationCounts[], int count);
+    void hsvToRGBAVX2(const float h[], const float s[], const float v[], unsigned char out[], int count, int channels, unsigned char alpha);
+    void escapeTimeAVX512(const double cr[], const double ci[], float out[], int count);
+    void escapeTimeAVX512(const float cr[], const float ci[], float out[], int count);
+    void paletteLookupAVX512(const palette::Palette &palette, unsigned char RGBarray[], const float iterationCounts[], int count);
+    void hsvToRGBAVX512(const float h[], const float s[], const float v[], unsigned char out[], int count, int channels, unsigned char alpha);
+#endif
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <color_spaces.h>
+
+// turns iteration counts into colors through a lookup table, so coloring a pixel is one
+// interpolated lookup instead of a HSVtoRGB call
+namespace palette
+{
+    // samples in one cycle of the palette. 6 * 256 puts a sample on every corner of the hue ramp
+    // (one each 60 degrees), so linear interpolation between samples reproduces it exactly
+    constexpr int paletteSize = 1536;
+
+    struct Palette
+    {
+        // one extra sample at the end repeats the first, so interpolation never has to wrap.
+        // Kept as floats in [0, 255] so rounding happens once, after interpolating
+        float r[paletteSize + 1];
+        float g[paletteSize + 1];
+        float b[paletteSize + 1];
+
+        float cyclesPerIteration; // how far along the cycle one iteration moves
+        float cycleOffset;        // where iteration 0 sits on the cycle, [0, 1)
+    };
+
+    // bakes the full saturation, full brightness hue ramp: hue = iterations * hueScale + hueOffset degrees
+    Palette makeHuePalette(float hueScale, float hueOffset);
+
+    // rotates the colors without rebaking the table
+    void shiftHue(Palette &palette, float degrees);
+
+    // RGBarray + 3 * k gets the color of iterationCounts[k], black for is_in_mandelbrot_set. Compiled
+    // per ISA and picked at startup like the escape time kernel (mandelbrot_kernel_def.cpp)
+    void colorIterationCounts(const Palette &palette, unsigned char RGBarray[], const float iterationCounts[], int count);
+}
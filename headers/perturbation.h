@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <big_fixed.h>
+
+// Deep zoom: one reference orbit Z_n is iterated at full precision (BigFixed) and rounded to double,
+// then every pixel only iterates its small difference dz_n = z_n - Z_n in double:
+//     dz_{n+1} = 2 Z_n dz_n + dz_n^2 + dc
+// When the pixel orbit gets closer to 0 than to the reference (|z| < |dz|, where dz loses its
+// precision) or the reference runs out, the pixel is rebased onto the start of the reference
+// orbit: dz = z, n = 0. That makes a single reference enough for the whole view.
+// dz and dc are plain doubles, so this only works while the pixel spacing is a normal double (the
+// workers flush denormals to zero). The app stops zooming at deepZoom::deepestZoom for that
+namespace perturbation
+{
+    struct ReferenceOrbit
+    {
+        BigComplex center;
+        int fractionalLimbs = 0;
+        int maxIterations = 0;  // the max_iterations it was iterated for
+        std::vector<double> zr; // Z_0 = 0, Z_1 = center, ... rounded to double
+        std::vector<double> zi;
+    };
+
+    // gives up early, with a partial orbit, once shouldStop is set
+    ReferenceOrbit computeReferenceOrbit(const BigComplex &center, int fractionalLimbs, const std::atomic<bool> &shouldStop);
+
+    // Bilinear approximation: while dz is tiny next to Z, the dz^2 term is negligible and l steps of
+    // the recurrence collapse into dz_{m+l} = A dz_m + B dc. Level k of the table holds the steps of
+    // length 2^k starting at m = 1 + j 2^k, each usable while |dz_m| < validRadius
+    struct BilinearApproximation
+    {
+        double ar, ai;
+        double br, bi;
+        double validRadius;
+    };
+
+    struct BilinearApproximationTable
+    {
+        std::vector<std::vector<BilinearApproximation>> levels;
+    };
+
+    // maxDcMagnitude bounds |dc| over every pixel that will use the table
+    BilinearApproximationTable buildBilinearApproximationTable(const ReferenceOrbit &orbit, double maxDcMagnitude);
+
+    // same meaning as smooth_iteration_count for c = orbit.center + dc
+    float perturbedSmoothIterationCount(const ReferenceOrbit &orbit, const BilinearApproximationTable &table, double dcr, double dci);
+}
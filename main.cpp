@@ -3,48 +3,46 @@
 #include <cmath>
 #include <thread>
 #include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <algorithm>
 #include <chrono>
-#include <color_spaces.h>
+#include <cstring>
+#include <type_traits>
+#if defined(__x86_64__) || defined(__i386__)
+#include <pmmintrin.h>
+#endif
+#include <palette.h>
+#include <mandelbrot_kernel.h>
+#include <big_fixed.h>
+#include <perturbation.h>
+#include <image_file.h>
+// HEADLESS builds the command line renderer at the bottom instead of the window, without GL and GLFW
+#ifndef HEADLESS
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
-
-constexpr int bailoutRadius = 100;
-constexpr int max_iterations = 1000;
-using precision = double;
+#endif
 
 constexpr int previewTextureSizeFactor = 10;
+constexpr int progressiveRenderCoarsestStep = 4; // the first pass of a full render computes 1 pixel in 4x4
 constexpr float baseForZoomScrollFunction = 0.5;
 constexpr int howManyPixelsToComputePerAsyncMandelbrotResume = (1000 * 1000) / 100;
 constexpr std::chrono::milliseconds frame_duration(17);
 
-enum
-{
-    is_in_mandelbrot_set = -10,
-};
-void colorThisPartBasedOnIterationCount(unsigned char RGBarray[], float iterations_number_took)
+namespace coloringState
 {
-    if (iterations_number_took == is_in_mandelbrot_set)
-    {
-        RGBarray[0] = 0; // R
-        RGBarray[1] = 0; // G
-        RGBarray[2] = 0; // B
-    }
-    else
-    {
-        float hue = iterations_number_took * 5 + 240;
-        HSV hsvColor{(float)fmod(hue, 360.0f), 1, 1};
-        RGB rgbColor = HSVtoRGB(hsvColor);
-        RGBarray[0] = rgbColor.r; // R
-        RGBarray[1] = rgbColor.g; // G
-        RGBarray[2] = rgbColor.b; // B
-    }
+    // hue = iterations * 5 + 240 degrees. Only changed while no render is running, the workers
+    // color their tiles with it
+    palette::Palette currentPalette = palette::makeHuePalette(5, 240);
 }
 
-struct complex
+// the coloring pass: iterationCounts[k] becomes the RGB pixel at RGBarray + 3 * k. Renders keep the
+// iteration counts, so a new palette only needs this and not the fractal again
+void colorIterationCounts(unsigned char RGBarray[], const float iterationCounts[], int count)
 {
-    precision r;
-    precision i;
-};
+    palette::colorIterationCounts(coloringState::currentPalette, RGBarray, iterationCounts, count);
+}
 
 void printComplex(complex c)
 {
@@ -54,48 +52,126 @@ void printComplex(complex c)
 namespace state
 {
 
+#ifndef HEADLESS
     GLFWwindow *window;
     GLuint shaderProgram;
+#endif
 
     int currentWidth = 1000;
     int currentHeight = 1000;
     std::vector<unsigned char> textureImage;
+    std::vector<float> iterationCounts; // what textureImage was colored from
+    int textureWidth = 0; // what the GL texture was last allocated with
+    int textureHeight = 0;
 
+    // deepCentralPoint is the real center of the view, centralPoint is it rounded to double
+    BigComplex deepCentralPoint{bigFixedFromDouble(-0.5, fractionalLimbsForZoom(3)), bigFixedFromDouble(0, fractionalLimbsForZoom(3))};
     complex centralPoint{-0.5, 0};
     precision zoom = 3;
 }
 
-inline float smooth_iteration_count(complex &c)
+#ifndef HEADLESS
+// texture uploads go through a ring of pixel buffer objects. The pixels are copied into the next
+// buffer and the texture is updated from there, which the GL does asynchronously instead of
+// copying out of our memory before the call returns. A buffer is only written again once the fence
+// of its last upload says the GL has read it. Persistently mapped buffers would let the workers
+// write straight into them, but they need GL 4.4 and glad is generated for 3.3 core
+namespace pixelBufferRing
 {
-    complex z{0, 0};
+    constexpr int pixelBufferCount = 2;
+
+    namespace pixelBufferRingState
+    {
+        GLuint pixelBuffers[pixelBufferCount] = {};
+        GLsync uploadFences[pixelBufferCount] = {};
+        size_t capacities[pixelBufferCount] = {}; // in bytes
+        int current = 0;
+    }
 
-    for (int i = 0; i < max_iterations; i++)
+    // write(unsigned char *buffer) fills byteCount bytes of the next buffer, then upload() makes the
+    // texture calls, while the buffer is bound to GL_PIXEL_UNPACK_BUFFER. Their data pointers are
+    // offsets into it then
+    template <class Write, class Upload>
+    void uploadThroughPixelBuffer(size_t byteCount, Write write, Upload upload)
     {
-        // z = z^2 + c
-        precision tempZI = 2 * z.r * z.i + c.i;
-        z.r = z.r * z.r - z.i * z.i + c.r;
-        z.i = tempZI;
+        using namespace pixelBufferRingState;
+        current = (current + 1) % pixelBufferCount;
+        if (pixelBuffers[current] == 0)
+        {
+            glGenBuffers(1, &pixelBuffers[current]);
+        }
+        GLbitfield unsynchronizedBit = GL_MAP_UNSYNCHRONIZED_BIT;
+        if (uploadFences[current] != nullptr)
+        {
+            // pixelBufferCount uploads ago, so almost always signaled already. The commands only
+            // have to be flushed once, after that it's just waiting
+            GLenum waitResult = glClientWaitSync(uploadFences[current], GL_SYNC_FLUSH_COMMANDS_BIT, 1000 * 1000 * 1000);
+            while (waitResult == GL_TIMEOUT_EXPIRED)
+            {
+                waitResult = glClientWaitSync(uploadFences[current], 0, 1000 * 1000 * 1000);
+            }
+            if (waitResult == GL_WAIT_FAILED)
+            {
+                // then nothing says the GL is done with the buffer, the mapping has to wait for it
+                unsynchronizedBit = 0;
+            }
+            glDeleteSync(uploadFences[current]);
+            uploadFences[current] = nullptr;
+        }
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffers[current]);
+        if (capacities[current] < byteCount)
+        {
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, byteCount, nullptr, GL_STREAM_DRAW);
+            capacities[current] = byteCount;
+        }
 
-        precision absoluteCsquared = z.r * z.r + z.i * z.i;
-        if (absoluteCsquared > bailoutRadius * bailoutRadius)
+        // the fence normally made sure the GL is done with it, so the mapping doesn't have to wait
+        void *buffer = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, byteCount, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | unsynchronizedBit);
+        if (buffer == nullptr)
         {
-            precision smoother = 2.0 - log2(log(absoluteCsquared));
-            return i + smoother;
+            std::cout << "couldn't map a pixel buffer\n";
+            exit(-1);
         }
+        write(static_cast<unsigned char *>(buffer));
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+        upload();
+        uploadFences[current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
     }
 
-    return is_in_mandelbrot_set;
-}
-inline float smooth_iteration_count(complex &&c)
-{
-    return smooth_iteration_count(c);
+    // what a texture call takes for data at byteOffset into the bound pixel buffer
+    inline const void *bufferOffset(size_t byteOffset)
+    {
+        return reinterpret_cast<const void *>(byteOffset);
+    }
 }
 
 void newTextureSize(std::vector<unsigned char> &newTextureData, int width, int height, GLuint shaderProgram)
 {
+    size_t byteCount = size_t(width) * height * 3;
+    bool isSameSize = width == state::textureWidth && height == state::textureHeight;
+
     // Update texture
     // binding maybe unnecessary glBindTexture(GL_TEXTURE_2D, texture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, newTextureData.data());
+    pixelBufferRing::uploadThroughPixelBuffer(
+        byteCount, [&](unsigned char *buffer)
+        { std::memcpy(buffer, newTextureData.data(), byteCount); },
+        [&]
+        {
+            if (isSameSize)
+            {
+                // no need to reallocate the texture
+                glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixelBufferRing::bufferOffset(0));
+            }
+            else
+            {
+                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, pixelBufferRing::bufferOffset(0));
+            }
+        });
+    state::textureWidth = width;
+    state::textureHeight = height;
 
     // Bind the texture to the shader uniform
     glUseProgram(shaderProgram);
@@ -104,9 +180,15 @@ void newTextureSize(std::vector<unsigned char> &newTextureData, int width, int h
 
 void updateTextureWithSameSize(std::vector<unsigned char> &newTextureData, int width, int height, GLuint shaderProgram)
 {
+    size_t byteCount = size_t(width) * height * 3;
+
     // Update texture
     // binding maybe unnecessary glBindTexture(GL_TEXTURE_2D, texture);
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, newTextureData.data());
+    pixelBufferRing::uploadThroughPixelBuffer(
+        byteCount, [&](unsigned char *buffer)
+        { std::memcpy(buffer, newTextureData.data(), byteCount); },
+        [&]
+        { glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixelBufferRing::bufferOffset(0)); });
 
     // Bind the texture to the shader uniform
     glUseProgram(shaderProgram);
@@ -124,7 +206,9 @@ void getNormalizedCursorPositionInWindow(GLFWwindow *window, double &normalizedX
     normalizedY = (double(state::currentHeight) - cursorY) / double(state::currentHeight);
 }
 
-complex getComplexNumberCursorPointsToInWindow(GLFWwindow *window)
+// where the cursor points to, relative to the center of the view. Positions are only ever handled
+// as offsets like this so the center itself can keep more precision than a double has
+complex getCursorOffsetFromCentralPoint(GLFWwindow *window, precision zoom)
 {
     using namespace state;
     double cursorX, cursorY;
@@ -133,8 +217,8 @@ complex getComplexNumberCursorPointsToInWindow(GLFWwindow *window)
     precision highestOfThem = (currentHeight > currentWidth) ? currentHeight : currentWidth;
 
     complex n;
-    n.r = centralPoint.r + (cursorX - 0.5) * (currentWidth / highestOfThem) * zoom;
-    n.i = centralPoint.i + (cursorY - 0.5) * (currentHeight / highestOfThem) * zoom;
+    n.r = (cursorX - 0.5) * (currentWidth / highestOfThem) * zoom;
+    n.i = (cursorY - 0.5) * (currentHeight / highestOfThem) * zoom;
 
     return n;
 }
@@ -151,44 +235,369 @@ void getNormalizedPositionCursorIsInZoomSpace(double &normalizedX, double &norma
     normalizedY = (cursorY - 0.5) * (currentHeight / highestOfThem) + 0.5;
 }
 
+#endif
+
 complex numberCentralShouldBeToMakePointBeInNormalizedZoomSpace(complex point, precision zoom, precision Nwidth, precision Nheight)
 {
     return complex{-zoom * Nwidth + point.r + zoom / 2, -zoom * Nheight + point.i + zoom / 2};
 }
 
-complex numberCentralShouldBeToMakePointBeInNormalizedWindow(complex point, precision zoom, precision Nwidth, precision Nheight)
+void moveCentralPointBy(complex delta)
 {
     using namespace state;
-    precision highestOfThem = (currentHeight > currentWidth) ? currentHeight : currentWidth;
-    complex n;
-    n.r = -(precision(Nwidth) - 0.5f) * (precision(currentWidth) / highestOfThem) * zoom + point.r;
-    n.i = -(precision(Nheight) - 0.5f) * (precision(currentHeight) / highestOfThem) * zoom + point.i;
-    return n;
+    int fractionalLimbs = fractionalLimbsForZoom(zoom);
+    deepCentralPoint.r = deepCentralPoint.r + bigFixedFromDouble(delta.r, fractionalLimbs);
+    deepCentralPoint.i = deepCentralPoint.i + bigFixedFromDouble(delta.i, fractionalLimbs);
+    centralPoint = complex{bigFixedToDouble(deepCentralPoint.r), bigFixedToDouble(deepCentralPoint.i)};
+}
+
+namespace mandelbrotCalculator::deepZoom
+{
+    // perturbation iterates dz and dc in plain double, and the workers flush denormals to zero, so
+    // pixels stop being told apart once the pixel spacing nears the smallest normal double
+    // (~2.2e-308). This leaves room for 8k wide windows and for dz shrinking below dc in a few
+    // iterations. Zooming stops here
+    constexpr precision deepestZoom = 1e-290;
+
+    namespace deepZoomState
+    {
+        // written by setView while no render is running, or by prepareIfNeeded before any pixel of
+        // the render is computed
+        perturbation::ReferenceOrbit referenceOrbit;
+        perturbation::BilinearApproximationTable approximationTable;
+        double approximationTableMaxDc = 0; // the |dc| the table was built for, 0 for none
+        complex referenceOffset; // view center - reference orbit center
+
+        precision viewZoom;
+        BigComplex viewCenter;
+        std::mutex preparationMutex;
+        std::atomic<bool> isPrepared = false;
+    }
+
+    // remembers the view the next render is for. The reference orbit, which takes seconds at deep
+    // zooms, is made for it by the render's workers (prepareIfNeeded), so it doesn't block the window
+    void setView(precision zoom, const BigComplex &center)
+    {
+        using namespace deepZoomState;
+        viewZoom = zoom;
+        viewCenter = center;
+        isPrepared = false;
+    }
+
+    // gets a reference orbit ready for the view of setView. The previous orbit is kept while it is
+    // precise enough, long enough and still close to the view (rebasing covers the rest), so
+    // previews and drags don't recompute it every frame. Workers call it before each perturbation
+    // tile: the first one does the work and the others wait for it. False when the render got
+    // stopped first, the previous orbit stays then
+    bool prepareIfNeeded(const std::atomic<bool> &shouldStop)
+    {
+        using namespace deepZoomState;
+        if (isPrepared.load(std::memory_order_acquire))
+        {
+            return true;
+        }
+
+        std::lock_guard<std::mutex> lock(preparationMutex);
+        if (isPrepared.load(std::memory_order_relaxed))
+        {
+            return true;
+        }
+
+        int fractionalLimbs = fractionalLimbsForZoom(viewZoom);
+        bool canReuseOrbit = false;
+        if (!referenceOrbit.zr.empty() && referenceOrbit.fractionalLimbs >= fractionalLimbs && referenceOrbit.maxIterations >= max_iterations)
+        {
+            referenceOffset = complex{bigFixedToDouble(viewCenter.r - referenceOrbit.center.r), bigFixedToDouble(viewCenter.i - referenceOrbit.center.i)};
+            canReuseOrbit = std::fabs(referenceOffset.r) < viewZoom && std::fabs(referenceOffset.i) < viewZoom;
+        }
+
+        if (!canReuseOrbit)
+        {
+            perturbation::ReferenceOrbit orbit = perturbation::computeReferenceOrbit(viewCenter, fractionalLimbs, shouldStop);
+            if (shouldStop.load())
+            {
+                return false;
+            }
+            referenceOrbit = std::move(orbit);
+            referenceOffset = complex{0, 0};
+            approximationTableMaxDc = 0;
+        }
+
+        // the view spans at most zoom in each direction around the center, so |dc| < |offset| + zoom.
+        // The table is built for twice that, so the frames of a pan keep using it. A table for much
+        // larger dc than needed skips fewer iterations, so zooming in far enough rebuilds it
+        double maxDcMagnitude = std::hypot(referenceOffset.r, referenceOffset.i) + viewZoom;
+        if (maxDcMagnitude > approximationTableMaxDc || 4 * maxDcMagnitude < approximationTableMaxDc)
+        {
+            approximationTableMaxDc = 2 * maxDcMagnitude;
+            approximationTable = perturbation::buildBilinearApproximationTable(referenceOrbit, approximationTableMaxDc);
+        }
+        isPrepared.store(true, std::memory_order_release);
+        return true;
+    }
+}
+
+namespace mandelbrotCalculator::numericTier
+{
+    // which number type the pixels of a render are iterated in
+    enum Tier
+    {
+        floatTier,
+        doubleTier,
+        doubleDoubleTier,
+        quadDoubleTier,
+        perturbationTier,
+    };
+
+    // relative rounding error (unit roundoff) of each direct tier's number type
+    constexpr precision floatEpsilon = 0x1p-24;
+    constexpr precision doubleEpsilon = 0x1p-53;
+    constexpr precision doubleDoubleEpsilon = 0x1p-104;
+    constexpr precision quadDoubleEpsilon = 0x1p-208;
+
+    // a tier is used only while neighbouring pixels are this many rounding errors apart, so the
+    // rounding of the coordinates and the first iterations stays well below a pixel
+    constexpr precision roundingErrorsPerPixel = 64;
+
+    // an orbit counts as periodic when it comes back closer than this share of the pixel spacing.
+    // Exterior orbits near parabolic points (cusps, where bulbs touch) crawl through a bottleneck in
+    // steps about as small as their distance to the point, which is a pixel or more, so they stay
+    // exterior
+    constexpr precision periodicityTolerancePerPixel = 1.0 / 1024;
+    // but never below this many rounding errors, under that the rounding noise of a cycle hides it
+    constexpr precision periodicityToleranceRoundingErrors = 4;
+
+    // the largest coordinate in a view of zoom around center, which is where rounding errors are
+    // biggest. Every orbit that doesn't escape stays within |z| <= 2, so that's a floor on the
+    // magnitudes involved
+    inline precision largestMagnitudeIn(precision zoom, complex center)
+    {
+        precision largestMagnitude = std::max(std::fabs(center.r) + zoom, std::fabs(center.i) + zoom);
+        return std::max(largestMagnitude, precision(2));
+    }
+
+    // can a type with this epsilon resolve the pixels of a view of zoom around center, width x height?
+    inline bool isAccurateEnough(precision epsilon, precision zoom, complex center, int width, int height)
+    {
+        precision highestOfThem = (height > width) ? height : width;
+        precision pixelSpacing = zoom / highestOfThem;
+        return pixelSpacing >= roundingErrorsPerPixel * epsilon * largestMagnitudeIn(zoom, center);
+    }
+
+    inline void setPeriodicityTolerance(precision epsilon, precision zoom, complex center, int width, int height)
+    {
+        precision pixelSpacing = zoom / std::max(width, height);
+        precision tolerance = std::max(pixelSpacing * periodicityTolerancePerPixel, periodicityToleranceRoundingErrors * epsilon * largestMagnitudeIn(zoom, center));
+        periodicityToleranceSquared = tolerance * tolerance;
+    }
+
+    namespace numericTierState
+    {
+        // what renders too deep for double use. Perturbation with its approximation table is by far
+        // the cheapest (at 1e-12 double-double is ~6x slower, at 1e-50 quad-double ~150x), but the
+        // direct tiers iterate every pixel exactly, which makes them the reference to check it against.
+        // A direct tier falls through to the next one when the view is deeper than it resolves.
+        // P in the window cycles it, --precision on the command line
+        Tier deepTier = perturbationTier;
+
+        // only written while no render is running
+        Tier tier = doubleTier;
+        basic_complex<float> floatCentralPoint;
+        basic_complex<DoubleDouble> doubleDoubleCentralPoint;
+        basic_complex<QuadDouble> quadDoubleCentralPoint;
+    }
+
+    inline Tier currentTier()
+    {
+        return numericTierState::tier;
+    }
+
+    // the names --precision takes for the deep tiers
+    inline const char *deepTierName(Tier deepTier)
+    {
+        return deepTier == doubleDoubleTier ? "dd" : deepTier == quadDoubleTier ? "qd" : "perturbation";
+    }
+
+    // false, and deepTier left alone, when name isn't one of them
+    inline bool deepTierFromName(const std::string &name, Tier &deepTier)
+    {
+        for (Tier candidate : {doubleDoubleTier, quadDoubleTier, perturbationTier})
+        {
+            if (name == deepTierName(candidate))
+            {
+                deepTier = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // picks the cheapest tier that still resolves the view, so shallow exploration runs in float
+    // (twice the SIMD lanes of double) and deep views stay correct. Called before every render,
+    // so the switch happens by itself while scrolling
+    void prepare(precision zoom, const BigComplex &center, int width, int height)
+    {
+        using namespace numericTierState;
+
+        complex approximateCenter{bigFixedToDouble(center.r), bigFixedToDouble(center.i)};
+        auto resolves = [&](precision epsilon)
+        {
+            return isAccurateEnough(epsilon, zoom, approximateCenter, width, height);
+        };
+
+        if (resolves(floatEpsilon))
+        {
+            tier = floatTier;
+            floatCentralPoint = {float(approximateCenter.r), float(approximateCenter.i)};
+            setPeriodicityTolerance(floatEpsilon, zoom, approximateCenter, width, height);
+        }
+        else if (resolves(doubleEpsilon))
+        {
+            tier = doubleTier;
+            setPeriodicityTolerance(doubleEpsilon, zoom, approximateCenter, width, height);
+        }
+        else if (deepTier == doubleDoubleTier && resolves(doubleDoubleEpsilon))
+        {
+            tier = doubleDoubleTier;
+            doubleDoubleCentralPoint = {bigFixedToDoubleDouble(center.r), bigFixedToDoubleDouble(center.i)};
+            setPeriodicityTolerance(doubleDoubleEpsilon, zoom, approximateCenter, width, height);
+        }
+        else if ((deepTier == doubleDoubleTier || deepTier == quadDoubleTier) && resolves(quadDoubleEpsilon))
+        {
+            tier = quadDoubleTier;
+            quadDoubleCentralPoint = {bigFixedToQuadDouble(center.r), bigFixedToQuadDouble(center.i)};
+            setPeriodicityTolerance(quadDoubleEpsilon, zoom, approximateCenter, width, height);
+        }
+        else
+        {
+            tier = perturbationTier;
+            deepZoom::setView(zoom, center);
+        }
+    }
 }
 
 namespace mandelbrotCalculator
 {
-    void computeMandelbrot(std::vector<unsigned char> &textureData, precision zoom, complex centralPoint, int width, int height)
+    struct PixelPosition
     {
-        textureData.resize(width * height * 3); // RGB format: 3 bytes per pixel
+        int x;
+        int y;
+    };
 
+    // a point anywhere in the view, in pixels: (0.5, 0) is halfway between pixels (0, 0) and (1, 0).
+    // The result of the kth one goes to iterationCounts[k] instead of to a pixel
+    struct SamplePosition
+    {
+        precision x;
+        precision y;
+    };
+
+    // computes the iteration counts of count pixels (or samples) in the number type T, handing them to
+    // kernel kernelBatchSize at a time. Pixel positions are double offsets added to origin
+    template <class T, class Position, class Kernel>
+    void computePixelsIn(float iterationCounts[], precision zoom, const basic_complex<T> &origin, int width, int height, const Position pixels[], int count, Kernel kernel)
+    {
         precision highestOfThem = (height > width) ? height : width;
 
-        for (int y = 0; y < height; ++y)
+        T cr[kernelBatchSize];
+        T ci[kernelBatchSize];
+        float iterations_number_took[kernelBatchSize];
+
+        for (int batchBegin = 0; batchBegin < count; batchBegin += kernelBatchSize)
         {
-            for (int x = 0; x < width; ++x)
+            int batchCount = (count - batchBegin < kernelBatchSize) ? count - batchBegin : kernelBatchSize;
+            const Position *batch = pixels + batchBegin;
+
+            for (int k = 0; k < batchCount; ++k)
+            {
+                cr[k] = origin.r + T((precision(batch[k].x) / precision(width)) * zoom * (precision(width) / highestOfThem) - zoom * (precision(width) / highestOfThem) / 2);
+                ci[k] = origin.i + T((precision(batch[k].y) / precision(height)) * zoom * (precision(height) / highestOfThem) - zoom * (precision(height) / highestOfThem) / 2);
+            }
+
+            kernel(cr, ci, iterations_number_took, batchCount);
+
+            for (int k = 0; k < batchCount; ++k)
             {
-                int index = (y * width + x) * 3;
+                if constexpr (std::is_same<Position, SamplePosition>::value)
+                {
+                    iterationCounts[batchBegin + k] = iterations_number_took[k];
+                }
+                else
+                {
+                    iterationCounts[size_t(batch[k].y) * width + batch[k].x] = iterations_number_took[k];
+                }
+            }
+        }
+    }
 
-                complex c;
-                c.r = (precision(x) / precision(width)) * zoom * (precision(width) / highestOfThem) - zoom * (precision(width) / highestOfThem) / 2 + centralPoint.r;
-                c.i = (precision(y) / precision(height)) * zoom * (precision(height) / highestOfThem) - zoom * (precision(height) / highestOfThem) / 2 + centralPoint.i;
+    // computes the iteration counts of count pixels (or samples) in the tier numericTier::prepare picked
+    template <class Position>
+    void computePixels(float iterationCounts[], precision zoom, complex centralPoint, int width, int height, const Position pixels[], int count)
+    {
+        using namespace numericTier;
+
+        auto directKernel = [](const auto *cr, const auto *ci, float *out, int count)
+        {
+            smooth_iteration_count_batch(cr, ci, out, count);
+        };
 
-                float iterations_number_took = smooth_iteration_count(c);
+        switch (currentTier())
+        {
+        case floatTier:
+            computePixelsIn(iterationCounts, zoom, numericTierState::floatCentralPoint, width, height, pixels, count, directKernel);
+            break;
+        case doubleTier:
+            computePixelsIn(iterationCounts, zoom, centralPoint, width, height, pixels, count, directKernel);
+            break;
+        case doubleDoubleTier:
+            computePixelsIn(iterationCounts, zoom, numericTierState::doubleDoubleCentralPoint, width, height, pixels, count, directKernel);
+            break;
+        case quadDoubleTier:
+            computePixelsIn(iterationCounts, zoom, numericTierState::quadDoubleCentralPoint, width, height, pixels, count, directKernel);
+            break;
+        case perturbationTier:
+            // the pixel is described by its offset from the reference orbit instead
+            computePixelsIn(iterationCounts, zoom, deepZoom::deepZoomState::referenceOffset, width, height, pixels, count,
+                            [](const precision *cr, const precision *ci, float *out, int count)
+                            {
+                                for (int k = 0; k < count; ++k)
+                                {
+                                    out[k] = perturbation::perturbedSmoothIterationCount(deepZoom::deepZoomState::referenceOrbit, deepZoom::deepZoomState::approximationTable, cr[k], ci[k]);
+                                }
+                            });
+            break;
+        }
+    }
 
-                colorThisPartBasedOnIterationCount(textureData.data() + index, iterations_number_took);
+    // computes the iteration counts of the pixels xBegin, xBegin + xStride, ... < xEnd of row y
+    void computeRowSpan(float iterationCounts[], precision zoom, complex centralPoint, int width, int height, int y, int xBegin, int xEnd, int xStride = 1)
+    {
+        PixelPosition pixels[kernelBatchSize];
+        int count = 0;
+        for (int x = xBegin; x < xEnd; x += xStride)
+        {
+            pixels[count++] = PixelPosition{x, y};
+            if (count == kernelBatchSize)
+            {
+                computePixels(iterationCounts, zoom, centralPoint, width, height, pixels, count);
+                count = 0;
             }
         }
+        computePixels(iterationCounts, zoom, centralPoint, width, height, pixels, count);
+    }
+
+    void computeMandelbrot(std::vector<unsigned char> &textureData, precision zoom, complex centralPoint, int width, int height)
+    {
+        // indices in size_t, a gigapixel image has more bytes than an int counts
+        textureData.resize(size_t(width) * height * 3); // RGB format: 3 bytes per pixel
+        std::vector<float> iterationCounts(size_t(width) * height);
+
+        for (int y = 0; y < height; ++y)
+        {
+            computeRowSpan(iterationCounts.data(), zoom, centralPoint, width, height, y, 0, width);
+            size_t rowBegin = size_t(y) * width;
+            colorIterationCounts(textureData.data() + rowBegin * 3, iterationCounts.data() + rowBegin, width);
+        }
     }
 
 }
@@ -199,6 +608,7 @@ namespace mandelbrotCalculator::asyncMandelbrot
     {
         precision highestOfThem;
         std::vector<unsigned char> textureData;
+        std::vector<float> iterationCounts;
         precision zoom;
         complex centralPoint;
         int width;
@@ -248,7 +658,8 @@ namespace mandelbrotCalculator::asyncMandelbrot
             std::cout << "tried to start a computation when another was still being computed\n";
             exit(-1);
         }
-        textureData.resize(width_ * height_ * 3);
+        textureData.resize(size_t(width_) * height_ * 3);
+        iterationCounts.resize(size_t(width_) * height_);
         highestOfThem = (width_ > height_) ? width_ : height_;
         zoom = zoom_;
         centralPoint = centralPoint_;
@@ -268,32 +679,25 @@ namespace mandelbrotCalculator::asyncMandelbrot
             exit(-1);
         }
 
-        int starting_x = x;
-
         for (; y < height; ++y)
         {
-
-            for (x = starting_x; x < width; ++x)
+            if (howManyTimes == 0)
             {
+                return;
+            }
 
-                if (howManyTimes == 0)
-                {
-                    return;
-                }
-                --howManyTimes;
-
-                int index = (y * width + x) * 3;
-
-                complex c;
-                c.r = (precision(x) / precision(width)) * zoom * (precision(width) / highestOfThem) - zoom * (precision(width) / highestOfThem) / 2 + centralPoint.r;
-                c.i = (precision(y) / precision(height)) * zoom * (precision(height) / highestOfThem) - zoom * (precision(height) / highestOfThem) / 2 + centralPoint.i;
-
-                float iterations_number_took = smooth_iteration_count(c);
+            int xEnd = (unsigned int)(width - x) > howManyTimes ? x + howManyTimes : width;
+            computeRowSpan(iterationCounts.data(), zoom, centralPoint, width, height, y, x, xEnd);
+            size_t spanBegin = size_t(y) * width + x;
+            colorIterationCounts(textureData.data() + spanBegin * 3, iterationCounts.data() + spanBegin, xEnd - x);
+            howManyTimes -= xEnd - x;
 
-                colorThisPartBasedOnIterationCount(textureData.data() + index, iterations_number_took);
+            if (xEnd < width)
+            {
+                x = xEnd;
+                return;
             }
-
-            starting_x = 0;
+            x = 0;
         }
 
         stop();
@@ -302,180 +706,1489 @@ namespace mandelbrotCalculator::asyncMandelbrot
 
 }
 
-namespace mandelbrotCalculator::parallelMandelbrot
+namespace mandelbrotCalculator::tileSampling
 {
-
-    namespace parallelMandelbrotState
+    // the samples of one pass over one tile: pixel (x0 + i * step, y0 + j * step) is sample (i, j)
+    struct Lattice
     {
-        std::vector<std::thread> threadPool;
-        std::vector<bool> readyThreadArray;
-        bool hasTextureBeenUsed = false;
-        bool haveIalreadyJoined = true;
-        std::atomic<bool> shouldStop = false;
-        int num_threads;
-
-        void setReadyThread(bool a)
+        float *iterationCounts;
+        precision zoom;
+        complex centralPoint;
+        int width;
+        int height;
+        int x0;
+        int y0;
+        int step;
+        int columns;
+        int rows;
+        std::vector<unsigned char> isKnown; // computed, filled or left by a coarser pass
+        std::vector<PixelPosition> pending;
+
+        float &at(int i, int j)
         {
-            for (int i = 0; i < num_threads; ++i)
-            {
-                readyThreadArray[i] = a;
-            }
+            return iterationCounts[size_t(y0 + j * step) * width + x0 + i * step];
         }
-    }
+    };
 
-    bool isComputing()
+    inline void need(Lattice &lattice, int i, int j)
     {
-        using namespace parallelMandelbrotState;
-        bool haveAllThreadsCompleted = true;
-        for (int i = 0; i < num_threads; ++i)
+        unsigned char &isKnown = lattice.isKnown[j * lattice.columns + i];
+        if (!isKnown)
         {
-            haveAllThreadsCompleted = haveAllThreadsCompleted && readyThreadArray[i];
+            isKnown = true;
+            lattice.pending.push_back(PixelPosition{lattice.x0 + i * lattice.step, lattice.y0 + j * lattice.step});
         }
-        // if at least one false, everything is false. AND everything
-        return !haveAllThreadsCompleted;
     }
 
-    bool isTextureReady()
+    // computes everything needed since the last call, in one batch so the SIMD kernel stays busy
+    void computeNeeded(Lattice &lattice)
     {
-        using namespace parallelMandelbrotState;
-        if (hasTextureBeenUsed)
-        {
-            return false;
-        }
-
-        return !isComputing();
+        computePixels(lattice.iterationCounts, lattice.zoom, lattice.centralPoint, lattice.width, lattice.height, lattice.pending.data(), lattice.pending.size());
+        lattice.pending.clear();
     }
 
-    void imUsingTheTexture()
+    Lattice makeLattice(float iterationCounts[], precision zoom, complex centralPoint, int width, int height,
+                        int x0, int y0, int x1, int y1, int step, bool isFirstPass)
     {
-        using namespace parallelMandelbrotState;
-        if (hasTextureBeenUsed == true)
+        int columns = (x1 - x0 + step - 1) / step;
+        int rows = (y1 - y0 + step - 1) / step;
+        Lattice lattice{iterationCounts, zoom, centralPoint, width, height, x0, y0, step, columns, rows,
+                        std::vector<unsigned char>(size_t(columns) * rows), {}};
+
+        // tiles start on multiples of 2 * step, so the samples of the coarser pass are the even ones
+        if (!isFirstPass)
         {
-            std::cout << "tried to use texture two times\n";
-            exit(-1);
+            for (int j = 0; j < lattice.rows; j += 2)
+            {
+                for (int i = 0; i < lattice.columns; i += 2)
+                {
+                    lattice.isKnown[j * lattice.columns + i] = true;
+                }
+            }
         }
-        hasTextureBeenUsed = true;
+        return lattice;
     }
+}
 
-    void initialize()
+namespace mandelbrotCalculator::marianiSilver
+{
+    // Mariani-Silver subdivision: compute the border of a rectangle, and if the border is uniform
+    // fill the inside with it, otherwise split the rectangle in four and do the same for each.
+    // What happens when a border is uniform:
+    enum Verification
     {
-        using namespace parallelMandelbrotState;
+        neverFill,   // subdivision is off, every pixel gets computed
+        trustBorder, // fill right away. Exact for black borders, since the set has no holes (its
+                     // complement is connected) nothing inside a border of the set can escape
+        checkCenter, // also compute the middle of the rectangle and only fill when it matches
+    };
 
-        num_threads = std::thread::hardware_concurrency() - 1;
-        if(num_threads == 0){
-            num_threads = 1;
-        }
+    // rectangles less than this many samples across are computed pixel by pixel
+    constexpr int smallestSubdividedSize = 4;
 
-        threadPool.resize(num_threads);
-        readyThreadArray.resize(num_threads);
+    namespace marianiSilverState
+    {
+        // M in the window cycles it, --fill-check on the command line
+        Verification verification = trustBorder;
+    }
 
-        setReadyThread(true);
+    // the names --fill-check takes
+    inline const char *verificationName(Verification verification)
+    {
+        return verification == neverFill ? "never" : verification == checkCenter ? "center" : "border";
     }
 
-    void computePiece(std::vector<unsigned char> &textureData, precision zoom, complex centralPoint, int width, int height, int begin, unsigned int howManyPixels, int myThreadID)
+    // false, and verification left alone, when name isn't one of them
+    inline bool verificationFromName(const std::string &name, Verification &verification)
     {
-        using namespace parallelMandelbrotState;
+        for (Verification candidate : {neverFill, trustBorder, checkCenter})
+        {
+            if (name == verificationName(candidate))
+            {
+                verification = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
 
-        precision highestOfThem = (height > width) ? height : width;
+    using namespace tileSampling;
 
-        int start_y = begin / width;
-        int start_x = begin % width;
+    // the rectangle of samples [i0, i1] x [j0, j1], borders included
+    struct SampleRectangle
+    {
+        int i0;
+        int j0;
+        int i1;
+        int j1;
+    };
 
-        // unconditional loop because howManyPixels does the job of going the right amount of pixels
-        for (int y = start_y;; ++y)
+    bool isBorderUniform(Lattice &lattice, const SampleRectangle &r)
+    {
+        float value = lattice.at(r.i0, r.j0);
+        for (int i = r.i0; i <= r.i1; ++i)
         {
-            if (shouldStop.load())
+            if (lattice.at(i, r.j0) != value || lattice.at(i, r.j1) != value)
             {
-                // readyThreadArray[myThreadID] = true;
-                return;
+                return false;
             }
-
-            for (int x = start_x; x < width; ++x)
+        }
+        for (int j = r.j0 + 1; j < r.j1; ++j)
+        {
+            if (lattice.at(r.i0, j) != value || lattice.at(r.i1, j) != value)
             {
-
-                if (howManyPixels == 0)
-                {
-                    readyThreadArray[myThreadID] = true;
-                    return;
-                }
-                --howManyPixels;
-
-                int index = (y * width + x) * 3;
-
-                complex c;
-                c.r = (precision(x) / precision(width)) * zoom * (precision(width) / highestOfThem) - zoom * (precision(width) / highestOfThem) / 2 + centralPoint.r;
-                c.i = (precision(y) / precision(height)) * zoom * (precision(height) / highestOfThem) - zoom * (precision(height) / highestOfThem) / 2 + centralPoint.i;
-
-                float iterations_number_took = smooth_iteration_count(c);
-
-                colorThisPartBasedOnIterationCount(textureData.data() + index, iterations_number_took);
+                return false;
             }
-            start_x = 0;
         }
+        return true;
     }
 
-    void join()
+    // samples inside that are known already (from a coarser pass, or the center) have to agree too
+    bool doesInsideAgree(Lattice &lattice, const SampleRectangle &r, float value)
     {
-        using namespace parallelMandelbrotState;
-        haveIalreadyJoined = true;
-        for (int i = 0; i < num_threads; ++i)
+        for (int j = r.j0 + 1; j < r.j1; ++j)
         {
-            threadPool[i].join();
+            for (int i = r.i0 + 1; i < r.i1; ++i)
+            {
+                if (lattice.isKnown[j * lattice.columns + i] && lattice.at(i, j) != value)
+                {
+                    return false;
+                }
+            }
         }
+        return true;
     }
 
-    void computeParallel(std::vector<unsigned char> &textureData, precision zoom, complex centralPoint, int width, int height)
+    // works through the rectangles one level of subdivision at a time, so the borders of a whole
+    // level go to the kernel together. Rectangles the size of a few SIMD lanes would leave most of
+    // them idle
+    void subdivide(Lattice &lattice, SampleRectangle whole, const std::atomic<bool> &shouldStop)
     {
-        using namespace parallelMandelbrotState;
+        using namespace marianiSilverState;
 
-        if (isComputing())
+        std::vector<SampleRectangle> level{whole};
+        std::vector<SampleRectangle> nextLevel;
+        std::vector<SampleRectangle> uniform;
+
+        while (!level.empty() && !shouldStop.load())
         {
-            std::cout << "tried to start a computation while another was still running\n";
-        }
+            for (const SampleRectangle &r : level)
+            {
+                for (int i = r.i0; i <= r.i1; ++i)
+                {
+                    need(lattice, i, r.j0);
+                    need(lattice, i, r.j1);
+                }
+                for (int j = r.j0 + 1; j < r.j1; ++j)
+                {
+                    need(lattice, r.i0, j);
+                    need(lattice, r.i1, j);
+                }
+            }
+            computeNeeded(lattice);
 
-        if(!haveIalreadyJoined){
-            join();
-        }
-        haveIalreadyJoined = false;
+            uniform.clear();
+            nextLevel.clear();
+            for (const SampleRectangle &r : level)
+            {
+                if (r.i1 - r.i0 < 2 || r.j1 - r.j0 < 2)
+                {
+                    continue; // nothing inside the border
+                }
+
+                if (isBorderUniform(lattice, r))
+                {
+                    uniform.push_back(r);
+                    if (verification == checkCenter)
+                    {
+                        need(lattice, (r.i0 + r.i1) / 2, (r.j0 + r.j1) / 2);
+                    }
+                    continue;
+                }
+                nextLevel.push_back(r);
+            }
+            computeNeeded(lattice);
+
+            for (const SampleRectangle &r : uniform)
+            {
+                float value = lattice.at(r.i0, r.j0);
+                if (!doesInsideAgree(lattice, r, value))
+                {
+                    nextLevel.push_back(r);
+                    continue;
+                }
+                for (int j = r.j0 + 1; j < r.j1; ++j)
+                {
+                    for (int i = r.i0 + 1; i < r.i1; ++i)
+                    {
+                        lattice.isKnown[j * lattice.columns + i] = true;
+                        lattice.at(i, j) = value;
+                    }
+                }
+            }
+
+            // what isn't filled gets split in four, or computed when it's small already
+            level.clear();
+            for (const SampleRectangle &r : nextLevel)
+            {
+                if (r.i1 - r.i0 <= smallestSubdividedSize || r.j1 - r.j0 <= smallestSubdividedSize)
+                {
+                    for (int j = r.j0 + 1; j < r.j1; ++j)
+                    {
+                        for (int i = r.i0 + 1; i < r.i1; ++i)
+                        {
+                            need(lattice, i, j);
+                        }
+                    }
+                    continue;
+                }
+
+                int iMiddle = (r.i0 + r.i1) / 2;
+                int jMiddle = (r.j0 + r.j1) / 2;
+                level.push_back({r.i0, r.j0, iMiddle, jMiddle});
+                level.push_back({iMiddle, r.j0, r.i1, jMiddle});
+                level.push_back({r.i0, jMiddle, iMiddle, r.j1});
+                level.push_back({iMiddle, jMiddle, r.i1, r.j1});
+            }
+        }
+        computeNeeded(lattice);
+    }
+
+    // computes the samples a pass of a progressive render (see RenderJob) needs in the tile
+    // [x0, x1) x [y0, y1), filling uniform rectangles instead of computing them
+    void computeTile(float iterationCounts[], precision zoom, complex centralPoint, int width, int height,
+                     int x0, int y0, int x1, int y1, int step, bool isFirstPass, const std::atomic<bool> &shouldStop)
+    {
+        Lattice lattice = makeLattice(iterationCounts, zoom, centralPoint, width, height, x0, y0, x1, y1, step, isFirstPass);
+        subdivide(lattice, SampleRectangle{0, 0, lattice.columns - 1, lattice.rows - 1}, shouldStop);
+    }
+}
+
+namespace mandelbrotCalculator::boundaryTracing
+{
+    // boundary tracing: starting from the border of the tile, every escaped sample passes the search
+    // on to its eight neighbours, while interior ones stop it. The search ends up walking around
+    // each interior component without entering it, so only the samples along its boundary pay the
+    // full max_iterations, and whatever it never reached is enclosed by the set and gets filled.
+    // Like Mariani-Silver this relies on the set having no holes (its complement is connected), an
+    // escaped pixel can't be surrounded by interior ones
+    namespace boundaryTracingState
+    {
+        // takes over from Mariani-Silver when on. Off by default, on the views measured it was
+        // never faster (up to 1.5x slower on views without much interior). B in the window,
+        // --boundary-tracing on the command line
+        bool isEnabled = false;
+    }
+
+    using namespace tileSampling;
+
+    void computeTile(float iterationCounts[], precision zoom, complex centralPoint, int width, int height,
+                     int x0, int y0, int x1, int y1, int step, bool isFirstPass, const std::atomic<bool> &shouldStop)
+    {
+        Lattice lattice = makeLattice(iterationCounts, zoom, centralPoint, width, height, x0, y0, x1, y1, step, isFirstPass);
+        std::vector<unsigned char> isReached(lattice.columns * lattice.rows);
+        std::vector<PixelPosition> front; // in samples, not pixels
+        std::vector<PixelPosition> nextFront;
+
+        auto reach = [&](int i, int j)
+        {
+            unsigned char &wasReached = isReached[j * lattice.columns + i];
+            if (!wasReached)
+            {
+                wasReached = true;
+                nextFront.push_back(PixelPosition{i, j});
+            }
+        };
+
+        for (int i = 0; i < lattice.columns; ++i)
+        {
+            reach(i, 0);
+            reach(i, lattice.rows - 1);
+        }
+        for (int j = 1; j < lattice.rows - 1; ++j)
+        {
+            reach(0, j);
+            reach(lattice.columns - 1, j);
+        }
+        // escaped samples of a coarser pass start the search too, so a stray one that the border
+        // can't reach doesn't get painted over
+        if (!isFirstPass)
+        {
+            for (int j = 0; j < lattice.rows; j += 2)
+            {
+                for (int i = 0; i < lattice.columns; i += 2)
+                {
+                    if (lattice.at(i, j) != is_in_mandelbrot_set)
+                    {
+                        reach(i, j);
+                    }
+                }
+            }
+        }
+
+        // one front at a time, so all of it goes to the kernel in a single batch
+        while (!nextFront.empty())
+        {
+            if (shouldStop.load())
+            {
+                return;
+            }
+
+            front.swap(nextFront);
+            nextFront.clear();
+            for (const PixelPosition &sample : front)
+            {
+                need(lattice, sample.x, sample.y);
+            }
+            computeNeeded(lattice);
+
+            for (const PixelPosition &sample : front)
+            {
+                int i = sample.x;
+                int j = sample.y;
+                if (lattice.at(i, j) == is_in_mandelbrot_set)
+                {
+                    continue;
+                }
+                // diagonals too, filaments one pixel wide often only touch diagonally
+                for (int nj = std::max(j - 1, 0); nj <= std::min(j + 1, lattice.rows - 1); ++nj)
+                {
+                    for (int ni = std::max(i - 1, 0); ni <= std::min(i + 1, lattice.columns - 1); ++ni)
+                    {
+                        reach(ni, nj);
+                    }
+                }
+            }
+        }
+
+        for (int j = 0; j < lattice.rows; ++j)
+        {
+            for (int i = 0; i < lattice.columns; ++i)
+            {
+                if (!lattice.isKnown[j * lattice.columns + i])
+                {
+                    lattice.at(i, j) = is_in_mandelbrot_set;
+                }
+            }
+        }
+    }
+}
+
+namespace mandelbrotCalculator::antiAliasing
+{
+    // a pixel is the one sample at its corner, so where the iteration count changes faster than the
+    // pixels (filaments, the noise around the boundary) the image aliases. Once every pixel of a
+    // render is known this pass goes over them again, and only the ones whose count differs from a
+    // neighbour's by more than a threshold get samplesPerSide x samplesPerSide samples spread over the
+    // pixel, colored and averaged. Smooth areas, most of a typical view, keep their single sample
+    namespace antiAliasingState
+    {
+        bool isEnabled = false;
+        int samplesPerSide = 3;
+        // 2 iterations are 10 degrees of hue with the default palette, a step the eye just notices
+        float iterationThreshold = 2;
+
+        // the samples of the pixels of state::iterationCounts that got more than one, so recoloring
+        // (a hue shift, turning it back on) doesn't iterate them again. A slot per pixel, -1 for
+        // none, each slot is samplesPerSide^2 counts in keptSampleCounts
+        std::vector<int> keptSampleSlots;
+        std::vector<float> keptSampleCounts;
+        int keptSlotCount = 0;
+        std::mutex keptSamplesMutex; // workers add slots while others read theirs
+    }
+
+    inline int samplesPerPixel()
+    {
+        int n = std::max(antiAliasingState::samplesPerSide, 1);
+        return n * n;
+    }
+
+    // drops the kept samples of the rectangle, whose pixels are about to be computed again. Only
+    // while no render is running
+    void forgetKeptSamples(int width, int height, int x0, int y0, int x1, int y1)
+    {
+        using namespace antiAliasingState;
+        if (keptSampleSlots.size() != size_t(width) * height)
+        {
+            keptSampleSlots.assign(size_t(width) * height, -1);
+            keptSampleCounts.clear();
+            keptSlotCount = 0;
+        }
+        for (int y = y0; y < y1; ++y)
+        {
+            std::fill(keptSampleSlots.begin() + size_t(y) * width + x0, keptSampleSlots.begin() + size_t(y) * width + x1, -1);
+        }
+    }
+
+    // forgotten slots stay in keptSampleCounts until there are as many of them as live ones. Only
+    // while no render is running
+    void compactKeptSamples()
+    {
+        using namespace antiAliasingState;
+        int liveSlots = 0;
+        for (int slot : keptSampleSlots)
+        {
+            liveSlots += slot >= 0;
+        }
+        if (keptSlotCount <= 2 * liveSlots)
+        {
+            return;
+        }
+
+        int counts = samplesPerPixel();
+        std::vector<float> compacted(size_t(liveSlots) * counts);
+        int nextSlot = 0;
+        for (int &slot : keptSampleSlots)
+        {
+            if (slot >= 0)
+            {
+                std::copy_n(keptSampleCounts.begin() + size_t(slot) * counts, counts, compacted.begin() + size_t(nextSlot) * counts);
+                slot = nextSlot++;
+            }
+        }
+        keptSampleCounts.swap(compacted);
+        keptSlotCount = liveSlots;
+    }
+
+    // colors the samples of count pixels (samplesPerPixel() counts each in sampleCounts) and writes
+    // their averages to the pixels of textureData
+    void colorAveraged(unsigned char textureData[], int width, const PixelPosition pixels[], const float sampleCounts[], int count)
+    {
+        int counts = samplesPerPixel();
+        std::vector<unsigned char> sampleColors(size_t(count) * counts * 3);
+        colorIterationCounts(sampleColors.data(), sampleCounts, count * counts);
+
+        for (int p = 0; p < count; ++p)
+        {
+            const PixelPosition &pixel = pixels[p];
+            const unsigned char *colors = sampleColors.data() + size_t(p) * counts * 3;
+            for (int channel = 0; channel < 3; ++channel)
+            {
+                int sum = 0;
+                for (int k = 0; k < counts; ++k)
+                {
+                    sum += colors[k * 3 + channel];
+                }
+                textureData[(size_t(pixel.y) * width + pixel.x) * 3 + channel] = (unsigned char)((sum + counts / 2) / counts);
+            }
+        }
+    }
+
+    // after state::textureImage got recolored from its single samples, puts the averages of the
+    // kept samples back. Only while no render is running
+    void recolorKeptSamples(unsigned char textureData[], int width)
+    {
+        using namespace antiAliasingState;
+        constexpr int pixelsPerBatch = 1024;
+        int counts = samplesPerPixel();
+        std::vector<PixelPosition> pixels;
+        std::vector<float> sampleCounts;
+        for (size_t k = 0; k < keptSampleSlots.size(); ++k)
+        {
+            int slot = keptSampleSlots[k];
+            if (slot < 0)
+            {
+                continue;
+            }
+            pixels.push_back(PixelPosition{int(k % width), int(k / width)});
+            sampleCounts.insert(sampleCounts.end(), keptSampleCounts.begin() + size_t(slot) * counts, keptSampleCounts.begin() + size_t(slot + 1) * counts);
+            if (pixels.size() == pixelsPerBatch)
+            {
+                colorAveraged(textureData, width, pixels.data(), sampleCounts.data(), pixels.size());
+                pixels.clear();
+                sampleCounts.clear();
+            }
+        }
+        colorAveraged(textureData, width, pixels.data(), sampleCounts.data(), pixels.size());
+    }
+
+    // does pixel (x, y) differ from any of its eight neighbours by more than the threshold? An inside
+    // pixel next to an escaped one always does
+    inline bool needsMoreSamples(const float iterationCounts[], int width, int height, int x, int y)
+    {
+        using namespace antiAliasingState;
+        float here = iterationCounts[size_t(y) * width + x];
+        bool isInside = here == is_in_mandelbrot_set;
+        for (int ny = std::max(y - 1, 0); ny <= std::min(y + 1, height - 1); ++ny)
+        {
+            for (int nx = std::max(x - 1, 0); nx <= std::min(x + 1, width - 1); ++nx)
+            {
+                float there = iterationCounts[size_t(ny) * width + nx];
+                if ((there == is_in_mandelbrot_set) != isInside || std::fabs(there - here) > iterationThreshold)
+                {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // recolors the pixels of the tile that need it in textureData. iterationCounts stays the one
+    // sample per pixel, it's only read, so neighbours in other tiles can be looked at while they're
+    // being worked on. With keepsSamples (renders of state::iterationCounts) pixels that have kept
+    // samples only get colored, and the ones computed are kept
+    void computeTile(unsigned char textureData[], const float iterationCounts[], precision zoom, complex centralPoint, int width, int height,
+                     int x0, int y0, int x1, int y1, bool keepsSamples, const std::atomic<bool> &shouldStop)
+    {
+        using namespace antiAliasingState;
+        int n = std::max(samplesPerSide, 1);
+        int counts = samplesPerPixel();
+
+        std::vector<PixelPosition> pixels;
+        for (int y = y0; y < y1; ++y)
+        {
+            for (int x = x0; x < x1; ++x)
+            {
+                if (needsMoreSamples(iterationCounts, width, height, x, y))
+                {
+                    pixels.push_back(PixelPosition{x, y});
+                }
+            }
+        }
+
+        // the grid is centered on the pixel's own sample, so with an odd samplesPerSide its middle
+        // sample is that one and isn't computed again
+        std::vector<precision> offsets(n);
+        for (int k = 0; k < n; ++k)
+        {
+            offsets[k] = (k - (n - 1) / precision(2)) / n;
+        }
+        int middle = (n % 2 == 1) ? counts / 2 : -1;
+
+        // a few kernel batches worth of pixels at a time, all their samples in one call
+        int pixelsPerBatch = std::max(1, kernelBatchSize * 4 / counts);
+        std::vector<SamplePosition> samples(size_t(pixelsPerBatch) * counts);
+        std::vector<float> computedCounts(samples.size());
+        std::vector<float> sampleCounts(samples.size());
+        std::vector<unsigned char> wasKept(pixelsPerBatch);
+        for (size_t batchBegin = 0; batchBegin < pixels.size(); batchBegin += pixelsPerBatch)
+        {
+            if (shouldStop.load())
+            {
+                return;
+            }
+
+            int batchCount = int(std::min(pixels.size() - batchBegin, size_t(pixelsPerBatch)));
+            const PixelPosition *batch = pixels.data() + batchBegin;
+            int computedCount = 0;
+            {
+                std::unique_lock<std::mutex> lock(keptSamplesMutex, std::defer_lock);
+                if (keepsSamples)
+                {
+                    lock.lock();
+                }
+                for (int p = 0; p < batchCount; ++p)
+                {
+                    int slot = keepsSamples ? keptSampleSlots[size_t(batch[p].y) * width + batch[p].x] : -1;
+                    wasKept[p] = slot >= 0;
+                    if (wasKept[p])
+                    {
+                        std::copy_n(keptSampleCounts.begin() + size_t(slot) * counts, counts, sampleCounts.begin() + size_t(p) * counts);
+                        continue;
+                    }
+                    for (int k = 0; k < counts; ++k)
+                    {
+                        if (k != middle)
+                        {
+                            samples[computedCount++] = SamplePosition{batch[p].x + offsets[k % n], batch[p].y + offsets[k / n]};
+                        }
+                    }
+                }
+            }
+            computePixels(computedCounts.data(), zoom, centralPoint, width, height, samples.data(), computedCount);
+
+            int computed = 0;
+            for (int p = 0; p < batchCount; ++p)
+            {
+                if (wasKept[p])
+                {
+                    continue;
+                }
+                for (int k = 0; k < counts; ++k)
+                {
+                    sampleCounts[p * counts + k] = (k == middle) ? iterationCounts[size_t(batch[p].y) * width + batch[p].x] : computedCounts[computed++];
+                }
+            }
+            colorAveraged(textureData, width, batch, sampleCounts.data(), batchCount);
+
+            if (keepsSamples && computedCount > 0)
+            {
+                std::lock_guard<std::mutex> lock(keptSamplesMutex);
+                for (int p = 0; p < batchCount; ++p)
+                {
+                    if (!wasKept[p])
+                    {
+                        keptSampleCounts.insert(keptSampleCounts.end(), sampleCounts.begin() + size_t(p) * counts, sampleCounts.begin() + size_t(p + 1) * counts);
+                        keptSampleSlots[size_t(batch[p].y) * width + batch[p].x] = keptSlotCount++;
+                    }
+                }
+            }
+        }
+    }
+}
+
+namespace mandelbrotCalculator::parallelMandelbrot
+{
+    // the frame is cut into tileSize x tileSize tiles. Interior tiles cost max_iterations per pixel and
+    // exterior ones a handful, so small tiles plus stealing keep every worker busy until the end
+    constexpr int tileSize = 32;
+
+    namespace parallelMandelbrotState
+    {
+        struct RenderJob
+        {
+            std::vector<unsigned char> *textureData;
+            std::vector<float> *iterationCounts;
+            precision zoom;
+            complex centralPoint;
+            int width;
+            int height;
+            // only every step-th pixel of every step-th row is computed and fills its step x step
+            // block. Passes after the first skip the pixels the previous, twice as coarse, one did
+            int step;
+            bool isFirstPass;
+            // recolors the pixels antiAliasing picks from more samples, after the passes that computed them
+            bool isAntiAliasingPass;
+        };
+
+        // pixels [x0, x1) x [y0, y1) of the current job
+        struct RenderTile
+        {
+            int x0;
+            int y0;
+            int x1;
+            int y1;
+        };
+
+        // each worker pops from the back of its own deque and steals from the front of the others
+        struct WorkerDeque
+        {
+            std::mutex mutex;
+            std::deque<RenderTile> tiles;
+        };
+
+        // the workers live from initialize() to terminate() and sleep on tilesAvailable between renders
+        std::vector<std::thread> threadPool;
+        std::vector<WorkerDeque> workerDeques;
+        RenderJob currentJob; // only written while no render is running
+        std::mutex stateMutex;
+        std::condition_variable tilesAvailable;
+        std::condition_variable renderFinished;
+        int tilesQueued = 0;        // sitting in a deque, guarded by stateMutex
+        int tilesNotFinished = 0;   // queued + being computed, guarded by stateMutex
+        bool shouldTerminate = false;
+
+        bool hasTextureBeenUsed = false;
+        bool wasLastRenderStopped = false; // so its buffers have holes
+        std::vector<RenderTile> currentRegions;
+        int nextPassStep = 0; // 0 when the current pass is the last one
+        bool isAntiAliasingPassNext = false; // after the last one
+        std::atomic<bool> shouldStop = false;
+        int num_threads;
+
+        // the tiles of the current pass in the order they got finished, so the main thread can upload
+        // them while the rest are still being computed. A worker claims the next slot, fills it and
+        // publishes it, the main thread takes the published slots in order. No lock, finishing a
+        // tile never waits on the main thread
+        struct FinishedTile
+        {
+            RenderTile tile;
+            std::atomic<bool> isPublished = false;
+        };
+        std::vector<FinishedTile> finishedTiles; // a slot per tile of the pass, only reallocated between passes
+        std::atomic<int> finishedTilesClaimed = 0;
+        int finishedTilesTaken = 0; // main thread only
+    }
+
+    bool isComputing()
+    {
+        using namespace parallelMandelbrotState;
+        std::lock_guard<std::mutex> lock(stateMutex);
+        return tilesNotFinished != 0;
+    }
+
+    bool isTextureReady()
+    {
+        using namespace parallelMandelbrotState;
+        if (hasTextureBeenUsed)
+        {
+            return false;
+        }
+
+        return !isComputing();
+    }
+
+    void imUsingTheTexture()
+    {
+        using namespace parallelMandelbrotState;
+        if (hasTextureBeenUsed == true)
+        {
+            std::cout << "tried to use texture two times\n";
+            exit(-1);
+        }
+        hasTextureBeenUsed = true;
+        finishedTilesTaken = finishedTilesClaimed.load(); // the whole texture got uploaded
+    }
+
+    // the next tile of the current pass that got finished since the last call, in the order they
+    // were. Its pixels in the job's textureData are final, the workers won't touch them again
+    bool takeFinishedTile(parallelMandelbrotState::RenderTile &tile)
+    {
+        using namespace parallelMandelbrotState;
+        if (finishedTilesTaken >= int(finishedTiles.size()) || !finishedTiles[finishedTilesTaken].isPublished.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        tile = finishedTiles[finishedTilesTaken].tile;
+        ++finishedTilesTaken;
+        return true;
+    }
+
+    void computeTile(const parallelMandelbrotState::RenderJob &job, const parallelMandelbrotState::RenderTile &tile)
+    {
+        using namespace parallelMandelbrotState;
+        int step = job.step;
+        float *iterationCounts = job.iterationCounts->data();
+
+        if (numericTier::currentTier() == numericTier::perturbationTier && !deepZoom::prepareIfNeeded(shouldStop))
+        {
+            return;
+        }
+
+        if (job.isAntiAliasingPass)
+        {
+            antiAliasing::computeTile(job.textureData->data(), iterationCounts, job.zoom, job.centralPoint, job.width, job.height,
+                                      tile.x0, tile.y0, tile.x1, tile.y1, job.iterationCounts == &state::iterationCounts, shouldStop);
+            return;
+        }
+
+        if (boundaryTracing::boundaryTracingState::isEnabled)
+        {
+            boundaryTracing::computeTile(iterationCounts, job.zoom, job.centralPoint, job.width, job.height,
+                                         tile.x0, tile.y0, tile.x1, tile.y1, step, job.isFirstPass, shouldStop);
+        }
+        else if (marianiSilver::marianiSilverState::verification != marianiSilver::neverFill)
+        {
+            marianiSilver::computeTile(iterationCounts, job.zoom, job.centralPoint, job.width, job.height,
+                                       tile.x0, tile.y0, tile.x1, tile.y1, step, job.isFirstPass, shouldStop);
+        }
+        else
+        {
+            // tiles start on multiples of tileSize, so the sample grid lines up with them
+            for (int y = tile.y0; y < tile.y1; y += step)
+            {
+                if (shouldStop.load())
+                {
+                    return;
+                }
+
+                bool wasRowDoneBefore = !job.isFirstPass && y % (2 * step) == 0;
+                if (wasRowDoneBefore)
+                {
+                    computeRowSpan(iterationCounts, job.zoom, job.centralPoint, job.width, job.height, y, tile.x0 + step, tile.x1, 2 * step);
+                }
+                else
+                {
+                    computeRowSpan(iterationCounts, job.zoom, job.centralPoint, job.width, job.height, y, tile.x0, tile.x1, step);
+                }
+            }
+        }
+
+        for (int y = tile.y0; y < tile.y1; ++y)
+        {
+            size_t rowBegin = size_t(y) * job.width + tile.x0;
+            if (step > 1)
+            {
+                // every pixel takes the value of the sample in the top left corner of its block
+                const float *sampleRow = iterationCounts + size_t(y - y % step) * job.width;
+                for (int x = tile.x0; x < tile.x1; ++x)
+                {
+                    iterationCounts[size_t(y) * job.width + x] = sampleRow[x - x % step];
+                }
+            }
+            colorIterationCounts(job.textureData->data() + rowBegin * 3, iterationCounts + rowBegin, tile.x1 - tile.x0);
+        }
+    }
+
+    bool takeTile(int myThreadID, parallelMandelbrotState::RenderTile &tile)
+    {
+        using namespace parallelMandelbrotState;
+
+        for (int i = 0; i < num_threads; ++i)
+        {
+            int victim = (myThreadID + i) % num_threads;
+            WorkerDeque &deque = workerDeques[victim];
+
+            std::lock_guard<std::mutex> lock(deque.mutex);
+            if (deque.tiles.empty())
+            {
+                continue;
+            }
+
+            if (victim == myThreadID)
+            {
+                tile = deque.tiles.back();
+                deque.tiles.pop_back();
+            }
+            else
+            {
+                tile = deque.tiles.front();
+                deque.tiles.pop_front();
+            }
+            return true;
+        }
+        return false;
+    }
+
+    void workerLoop(int myThreadID)
+    {
+        using namespace parallelMandelbrotState;
+
+#if defined(__x86_64__) || defined(__i386__)
+        // past a zoom of ~1e-150 the dz^2 terms of perturbation underflow, and denormal arithmetic
+        // is several times slower. Those terms are far below the 2 Z dz next to them, so flushing
+        // them doesn't change a pixel as long as dc itself stays normal, which deepZoom::deepestZoom
+        // makes sure of
+        _MM_SET_FLUSH_ZERO_MODE(_MM_FLUSH_ZERO_ON);
+        _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
+#endif
+
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(stateMutex);
+                tilesAvailable.wait(lock, []
+                                    { return shouldTerminate || tilesQueued > 0; });
+                if (shouldTerminate)
+                {
+                    return;
+                }
+            }
+
+            RenderTile tile;
+            while (takeTile(myThreadID, tile))
+            {
+                {
+                    std::lock_guard<std::mutex> lock(stateMutex);
+                    --tilesQueued;
+                }
+
+                computeTile(currentJob, tile);
+
+                // a stopped tile is only partly computed, it never gets shown
+                if (!shouldStop.load())
+                {
+                    FinishedTile &slot = finishedTiles[finishedTilesClaimed.fetch_add(1)];
+                    slot.tile = tile;
+                    slot.isPublished.store(true, std::memory_order_release);
+                }
+
+                std::lock_guard<std::mutex> lock(stateMutex);
+                --tilesNotFinished;
+                if (tilesNotFinished == 0)
+                {
+                    renderFinished.notify_all();
+                }
+            }
+        }
+    }
+
+    void initialize()
+    {
+        using namespace parallelMandelbrotState;
+
+        num_threads = std::thread::hardware_concurrency() - 1;
+        if(num_threads <= 0){
+            num_threads = 1;
+        }
+
+        workerDeques = std::vector<WorkerDeque>(num_threads);
+        threadPool.reserve(num_threads);
+        for (int i = 0; i < num_threads; ++i)
+        {
+            threadPool.emplace_back(workerLoop, i);
+        }
+    }
+
+    // waits until the current render is done (or stopped)
+    void join()
+    {
+        using namespace parallelMandelbrotState;
+        std::unique_lock<std::mutex> lock(stateMutex);
+        renderFinished.wait(lock, []
+                            { return tilesNotFinished == 0; });
+    }
+
+    void startPass(int step, bool isFirstPass, bool isAntiAliasingPass = false)
+    {
+        using namespace parallelMandelbrotState;
+
+        if (isAntiAliasingPass)
+        {
+            antiAliasing::compactKeptSamples();
+        }
+
+        hasTextureBeenUsed = false;
+        currentJob.step = step;
+        currentJob.isFirstPass = isFirstPass;
+        currentJob.isAntiAliasingPass = isAntiAliasingPass;
+        nextPassStep = isAntiAliasingPass ? 0 : step / 2;
+        isAntiAliasingPassNext = !isAntiAliasingPass && step == 1 && antiAliasing::antiAliasingState::isEnabled;
+
+        std::vector<RenderTile> tiles;
+        for (const RenderTile &region : currentRegions)
+        {
+            for (int y0 = region.y0; y0 < region.y1; y0 += tileSize)
+            {
+                for (int x0 = region.x0; x0 < region.x1; x0 += tileSize)
+                {
+                    tiles.push_back(RenderTile{x0, y0, std::min(x0 + tileSize, region.x1), std::min(y0 + tileSize, region.y1)});
+                }
+            }
+        }
+        int howManyTiles = tiles.size();
+
+        // before the first tile is dealt, a worker still leaving the last pass could pick it up
+        finishedTiles = std::vector<FinishedTile>(howManyTiles);
+        finishedTilesClaimed.store(0);
+        finishedTilesTaken = 0;
+
+        // deal the tiles out round robin so every worker starts with a similar mix of rows
+        for (int i = 0; i < howManyTiles; ++i)
+        {
+            WorkerDeque &deque = workerDeques[i % num_threads];
+            std::lock_guard<std::mutex> lock(deque.mutex);
+            deque.tiles.push_back(tiles[i]);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            tilesQueued += howManyTiles;
+            tilesNotFinished += howManyTiles;
+        }
+        tilesAvailable.notify_all();
+    }
+
+    // fills the regions of iterationCounts and textureData (colored from it) in the background. The
+    // rest of both buffers is left as it is. With a coarsestStep above 1 the render is progressive:
+    // the first pass computes one pixel per coarsestStep x coarsestStep block, and every
+    // refineIfNeeded() after the texture was taken halves the step until every pixel is done.
+    // Regions have to start on multiples of coarsestStep
+    void computeParallelRegions(std::vector<unsigned char> &textureData, std::vector<float> &iterationCounts, precision zoom, complex centralPoint, int width, int height,
+                                const std::vector<parallelMandelbrotState::RenderTile> &regions, int coarsestStep = 1)
+    {
+        using namespace parallelMandelbrotState;
+
+        if (isComputing())
+        {
+            std::cout << "tried to start a computation while another was still running\n";
+            join();
+        }
+
+        textureData.resize(size_t(width) * height * 3); // RGB format: 3 bytes per pixel
+        iterationCounts.resize(size_t(width) * height);
+
+        // the samples antiAliasing kept for the regions are about to be outdated
+        if (&iterationCounts == &state::iterationCounts)
+        {
+            for (const RenderTile &region : regions)
+            {
+                antiAliasing::forgetKeptSamples(width, height, region.x0, region.y0, region.x1, region.y1);
+            }
+        }
+
+        wasLastRenderStopped = false;
+        currentJob = RenderJob{&textureData, &iterationCounts, zoom, centralPoint, width, height, coarsestStep, true, false};
+        currentRegions = regions;
+        startPass(coarsestStep, true);
+    }
+
+    // starts the next, finer pass of a progressive render once the previous one is done, and the
+    // anti-aliasing pass after the last one
+    void refineIfNeeded()
+    {
+        using namespace parallelMandelbrotState;
+        if (isComputing())
+        {
+            return;
+        }
+        if (nextPassStep != 0)
+        {
+            startPass(nextPassStep, false);
+        }
+        else if (isAntiAliasingPassNext)
+        {
+            // unless it got turned off since the last pass started
+            isAntiAliasingPassNext = false;
+            if (antiAliasing::antiAliasingState::isEnabled)
+            {
+                startPass(1, false, true);
+            }
+        }
+    }
+
+    // runs the passes that are left and waits for them, for callers without a main loop
+    void finish()
+    {
+        using namespace parallelMandelbrotState;
+        join();
+        while (nextPassStep != 0 || isAntiAliasingPassNext)
+        {
+            refineIfNeeded();
+            join();
+        }
+    }
+
+    // fills iterationCounts and textureData (colored from it) in the background
+    void computeParallel(std::vector<unsigned char> &textureData, std::vector<float> &iterationCounts, precision zoom, complex centralPoint, int width, int height, int coarsestStep = 1)
+    {
+        computeParallelRegions(textureData, iterationCounts, zoom, centralPoint, width, height, {{0, 0, width, height}}, coarsestStep);
+    }
+
+    // true when the last render ran to the end, so every pixel of its buffers is valid
+    bool didLastRenderFinish()
+    {
+        using namespace parallelMandelbrotState;
+        return !isComputing() && !wasLastRenderStopped && nextPassStep == 0 && !isAntiAliasingPassNext;
+    }
+
+    // same, but already while the anti-aliasing pass runs, which only changes colors
+    bool isEveryIterationCountFinal()
+    {
+        using namespace parallelMandelbrotState;
+        return (!isComputing() || currentJob.isAntiAliasingPass) && !wasLastRenderStopped && nextPassStep == 0;
+    }
+
+    // anti-aliases the finished render over the whole frame, when it gets turned on. Pixels that
+    // still have their kept samples only get colored
+    void startAntiAliasingPass()
+    {
+        using namespace parallelMandelbrotState;
+        if (antiAliasing::antiAliasingState::isEnabled && didLastRenderFinish())
+        {
+            currentRegions = {{0, 0, currentJob.width, currentJob.height}};
+            startPass(1, false, true);
+        }
+    }
+
+    void stop()
+    {
+        using namespace parallelMandelbrotState;
+        shouldStop.store(true);
+
+        // tiles nobody picked up yet are simply dropped
+        int tilesDropped = 0;
+        for (WorkerDeque &deque : workerDeques)
+        {
+            std::lock_guard<std::mutex> lock(deque.mutex);
+            tilesDropped += deque.tiles.size();
+            deque.tiles.clear();
+        }
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            tilesQueued -= tilesDropped;
+            tilesNotFinished -= tilesDropped;
+            if (tilesNotFinished == 0)
+            {
+                renderFinished.notify_all();
+            }
+        }
+
+        join();
+        shouldStop.store(false);
+        hasTextureBeenUsed = true;
+        wasLastRenderStopped = true;
+        nextPassStep = 0;
+        isAntiAliasingPassNext = false;
+    }
+
+    void stopIfComputing(){
+        using namespace parallelMandelbrotState;
+        if(isComputing()){
+            stop();
+        }
+        else if (nextPassStep != 0 || isAntiAliasingPassNext)
+        {
+            // between two passes of a progressive render
+            nextPassStep = 0;
+            isAntiAliasingPassNext = false;
+            wasLastRenderStopped = true;
+        }
+    }
+
+    // stops the current render and shuts the workers down, only at exit
+    void terminate()
+    {
+        using namespace parallelMandelbrotState;
+        stopIfComputing();
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            shouldTerminate = true;
+        }
+        tilesAvailable.notify_all();
+        for (std::thread &worker : threadPool)
+        {
+            worker.join();
+        }
+        threadPool.clear();
+    }
+}
+
+namespace mandelbrotCalculator::iterationBudget
+{
+    // max_iterations is a guess from the zoom (detail near the set escapes later the deeper the view)
+    // times a correction learned from the escape counts of the last finished render. Too low a
+    // budget turns that detail black, too high makes every interior pixel the periodicity check
+    // misses pay for nothing
+    constexpr int smallestBudget = 256;
+    constexpr int largestBudget = 1 << 18;
+    constexpr int budgetPerZoomHalving = 250; // per halving of the zoom below the default 3
+
+    // a budget is right when at most this share of the escaped pixels escapes in its last half. More
+    // and the detail it cut off shows, doubles it. Less than this in its last three quarters, halves it
+    constexpr double acceptableLateEscapeShare = 0.01;
+
+    namespace iterationBudgetState
+    {
+        double correction = 1;
+        bool hasLearnedFromLastRender = true;
+        int fixedBudget = 0; // used as it is instead when set (the command line's --iterations)
+    }
+
+    inline int budgetForZoom(precision zoom)
+    {
+        precision halvings = std::max(precision(0), std::log2(precision(3) / zoom));
+        return std::max(smallestBudget, int(budgetPerZoomHalving * halvings));
+    }
+
+    // sets max_iterations for a render of a view this deep, only while no render is running
+    void prepare(precision zoom)
+    {
+        using namespace iterationBudgetState;
+        double budget = budgetForZoom(zoom) * correction;
+        max_iterations = int(std::min(std::max(budget, double(smallestBudget)), double(largestBudget)));
+        if (fixedBudget > 0)
+        {
+            max_iterations = fixedBudget;
+        }
+        hasLearnedFromLastRender = false;
+    }
+
+    // updates the correction from the last render once it finished. True when its budget was too
+    // low and the new one is larger, so the view is worth rendering again. Only renders into
+    // state::iterationCounts count, the buffers of previews are gone by the time they finish
+    bool learnFromFinishedRender()
+    {
+        using namespace iterationBudgetState;
+        using parallelMandelbrot::parallelMandelbrotState::currentJob;
+        if (hasLearnedFromLastRender || !parallelMandelbrot::isEveryIterationCountFinal() || currentJob.iterationCounts != &state::iterationCounts)
+        {
+            return false;
+        }
+        hasLearnedFromLastRender = true;
+        if (fixedBudget > 0)
+        {
+            return false;
+        }
+
+        // regions renders keep the budget, so the whole buffer was computed with max_iterations
+        long long escaped = 0;
+        long long escapedInLastHalf = 0;
+        long long escapedInLastThreeQuarters = 0;
+        for (float iterations : *currentJob.iterationCounts)
+        {
+            if (iterations == is_in_mandelbrot_set)
+            {
+                continue;
+            }
+            ++escaped;
+            escapedInLastHalf += iterations > max_iterations / 2;
+            escapedInLastThreeQuarters += iterations > max_iterations / 4;
+        }
+        if (escaped == 0)
+        {
+            return false; // all inside, nothing to go by
+        }
+
+        double usedCorrection = double(max_iterations) / budgetForZoom(currentJob.zoom);
+        bool wasTooLow = escapedInLastHalf > acceptableLateEscapeShare * escaped && max_iterations < largestBudget;
+        if (wasTooLow)
+        {
+            correction = usedCorrection * 2;
+        }
+        else if (escapedInLastThreeQuarters < acceptableLateEscapeShare * escaped)
+        {
+            correction = usedCorrection / 2;
+        }
+        else
+        {
+            correction = usedCorrection;
+        }
+        correction = std::min(std::max(correction, 1.0 / 16), 64.0);
+        // at the largest correction the budget stays the same, rendering again would loop forever
+        return wasTooLow && correction > usedCorrection;
+    }
+}
+
+namespace mandelbrotCalculator
+{
+    // starts a parallel render of the current view (state::zoom around state::deepCentralPoint),
+    // progressive when coarsestStep is above 1
+    void computeCurrentView(std::vector<unsigned char> &textureData, std::vector<float> &iterationCounts, int width, int height, int coarsestStep = 1)
+    {
+        parallelMandelbrot::stopIfComputing();
+        iterationBudget::prepare(state::zoom);
+        numericTier::prepare(state::zoom, state::deepCentralPoint, width, height);
+        parallelMandelbrot::computeParallel(textureData, iterationCounts, state::zoom, state::centralPoint, width, height, coarsestStep);
+    }
+
+    // same, but only the regions are computed, the rest of the buffers is kept. The iteration budget
+    // stays what it was, so the regions match the pixels around them
+    void computeCurrentViewRegions(std::vector<unsigned char> &textureData, std::vector<float> &iterationCounts, int width, int height,
+                                   const std::vector<parallelMandelbrot::parallelMandelbrotState::RenderTile> &regions)
+    {
+        parallelMandelbrot::stopIfComputing();
+        iterationBudget::iterationBudgetState::hasLearnedFromLastRender = false;
+        numericTier::prepare(state::zoom, state::deepCentralPoint, width, height);
+        parallelMandelbrot::computeParallelRegions(textureData, iterationCounts, state::zoom, state::centralPoint, width, height, regions);
+    }
+}
+
+namespace mandelbrotCalculator::incrementalPan
+{
+    // a drag moves the view by whole pixels, so what's already in state::iterationCounts and
+    // state::textureImage only has to be moved, and just the strips that come into view get computed
+    namespace incrementalPanState
+    {
+        bool isPanning = false;
+        // how far the buffers have been shifted since the drag started, in pixels
+        int shiftedX = 0;
+        int shiftedY = 0;
+        // the regions the last computeExposedRegions started on, in the buffers as they are now.
+        // The next move computes them again if that render got stopped before it finished
+        std::vector<parallelMandelbrot::parallelMandelbrotState::RenderTile> unfinishedRegions;
+    }
+
+    // moves a width x height image with channels values per pixel so that (x, y) gets what was at
+    // (x + dx, y + dy). Pixels that come in from outside keep whatever was there
+    template <class T>
+    void shiftPixels(std::vector<T> &pixels, int width, int height, int channels, int dx, int dy)
+    {
+        int xBegin = std::max(0, -dx);
+        int xEnd = std::min(width, width - dx);
+        if (xBegin >= xEnd)
+        {
+            return;
+        }
+
+        // walk the rows so that a source row is read before it gets overwritten
+        int yBegin = (dy > 0) ? 0 : height - 1;
+        int yStep = (dy > 0) ? 1 : -1;
+        for (int y = yBegin; y >= 0 && y < height; y += yStep)
+        {
+            int sourceY = y + dy;
+            if (sourceY < 0 || sourceY >= height)
+            {
+                continue;
+            }
+            T *destination = pixels.data() + (size_t(y) * width + xBegin) * channels;
+            const T *source = pixels.data() + (size_t(sourceY) * width + xBegin + dx) * channels;
+            std::memmove(destination, source, size_t(xEnd - xBegin) * channels * sizeof(T));
+        }
+    }
+
+    inline bool isActive()
+    {
+        return incrementalPanState::isPanning;
+    }
+
+    // called when a drag starts. Panning only reuses the buffers when they hold a finished render
+    // of the current view, otherwise the drag falls back to low resolution previews
+    void begin()
+    {
+        using namespace incrementalPanState;
+        isPanning = parallelMandelbrot::isEveryIterationCountFinal() &&
+                    state::iterationCounts.size() == size_t(state::currentWidth) * state::currentHeight;
+        shiftedX = 0;
+        shiftedY = 0;
+        unfinishedRegions.clear();
+    }
+
+    // waits for the strips of the last move, so the buffers hold the whole view again
+    void end()
+    {
+        using namespace incrementalPanState;
+        parallelMandelbrot::join();
+        isPanning = false;
+    }
+
+    // moves the view to dragStartCentralPoint + offset, rounded to whole pixels so the buffers can
+    // be reused. The strips that came into view still hold what was there before, until
+    // computeExposedRegions fills them in. Returns false when the view didn't move by a whole
+    // pixel, in which case nothing changes
+    bool panTo(const BigComplex &dragStartCentralPoint, complex offset)
+    {
+        using namespace incrementalPanState;
+        using parallelMandelbrot::parallelMandelbrotState::RenderTile;
+
+        int width = state::currentWidth;
+        int height = state::currentHeight;
+        precision pixelSpacing = state::zoom / std::max(width, height);
+        int targetX = (int)std::lround(offset.r / pixelSpacing);
+        int targetY = (int)std::lround(offset.i / pixelSpacing);
+        int dx = targetX - shiftedX;
+        int dy = targetY - shiftedY;
+        if (dx == 0 && dy == 0)
+        {
+            return false;
+        }
+
+        // including the anti-aliasing pass, the strips' edge pixels are only final after it
+        if (parallelMandelbrot::didLastRenderFinish())
+        {
+            unfinishedRegions.clear();
+        }
+        parallelMandelbrot::stopIfComputing();
+        shiftPixels(state::iterationCounts, width, height, 1, dx, dy);
+        shiftPixels(state::textureImage, width, height, 3, dx, dy);
+        if (antiAliasing::antiAliasingState::keptSampleSlots.size() == state::iterationCounts.size())
+        {
+            shiftPixels(antiAliasing::antiAliasingState::keptSampleSlots, width, height, 1, dx, dy);
+        }
+        shiftedX = targetX;
+        shiftedY = targetY;
+
+        state::deepCentralPoint = dragStartCentralPoint;
+        moveCentralPointBy(complex{targetX * pixelSpacing, targetY * pixelSpacing});
+
+        // the rows that came in over the whole width, then the columns next to the rest. Each
+        // reaches one pixel into what was on screen, whose neighbours were off screen until now, so
+        // anti-aliasing decides about it again
+        std::vector<RenderTile> exposed;
+        int keptRowsBegin = 0;
+        int keptColumnsBegin = 0;
+        int keptColumnsEnd = width;
+        int keptRowsEnd = height;
+        if (dy > 0)
+        {
+            keptRowsEnd = std::max(height - dy - 1, 0);
+            exposed.push_back({0, keptRowsEnd, width, height});
+        }
+        if (dy < 0)
+        {
+            keptRowsBegin = std::min(-dy + 1, height);
+            exposed.push_back({0, 0, width, keptRowsBegin});
+        }
+        if (dx > 0)
+        {
+            keptColumnsEnd = std::max(width - dx - 1, 0);
+            exposed.push_back({keptColumnsEnd, keptRowsBegin, width, keptRowsEnd});
+        }
+        if (dx < 0)
+        {
+            keptColumnsBegin = std::min(-dx + 1, width);
+            exposed.push_back({0, keptRowsBegin, keptColumnsBegin, keptRowsEnd});
+        }
+
+        // unfinished regions moved along with the pixels. What's left of them in the kept part
+        // doesn't overlap the new strips
+        for (const RenderTile &region : unfinishedRegions)
+        {
+            RenderTile moved{std::max(region.x0 - dx, keptColumnsBegin), std::max(region.y0 - dy, keptRowsBegin),
+                             std::min(region.x1 - dx, keptColumnsEnd), std::min(region.y1 - dy, keptRowsEnd)};
+            if (moved.x0 < moved.x1 && moved.y0 < moved.y1)
+            {
+                exposed.push_back(moved);
+            }
+        }
+        unfinishedRegions = exposed;
+        return true;
+    }
+
+    // starts computing what panTo exposed. Doesn't wait for it, the tiles show up as they finish
+    void computeExposedRegions()
+    {
+        computeCurrentViewRegions(state::textureImage, state::iterationCounts, state::currentWidth, state::currentHeight, incrementalPanState::unfinishedRegions);
+    }
+}
+
+namespace mandelbrotCalculator::zoomReprojection
+{
+    // on scroll the last full resolution frame is resampled to the new view and shown right away,
+    // while the real render of the new view replaces it
+    namespace zoomReprojectionState
+    {
+        // state::textureImage and state::iterationCounts hold an approximation of the current view,
+        // even if the render into them didn't finish. False while they still hold another view
+        bool doBuffersShowCurrentView = true;
+    }
 
-        textureData.resize(width * height * 3); // RGB format: 3 bytes per pixel
+    inline void buffersNoLongerShowCurrentView()
+    {
+        zoomReprojectionState::doBuffersShowCurrentView = false;
+    }
 
-        setReadyThread(false);
-        hasTextureBeenUsed = false;
+    bool canReproject()
+    {
+        using namespace zoomReprojectionState;
+        using parallelMandelbrot::parallelMandelbrotState::currentJob;
+        bool areBuffersOfThisSize = state::iterationCounts.size() == size_t(state::currentWidth) * state::currentHeight &&
+                                    state::textureImage.size() == state::iterationCounts.size() * 3;
+        // a finished render only counts when it was into the buffers, not a preview's
+        bool didRenderIntoBuffersFinish = parallelMandelbrot::didLastRenderFinish() && currentJob.iterationCounts == &state::iterationCounts;
+        return areBuffersOfThisSize && (doBuffersShowCurrentView || didRenderIntoBuffersFinish);
+    }
 
-        int nPixelsPerThread = (width * height) / num_threads;
-        int nExtraPixels = (width * height) % num_threads; // special threads will compute one extra pixel. We are diving as even as possible
+    // resamples the buffers, which show the view at oldZoom around the center before it was moved
+    // by centerDelta, to the current view. Nearest neighbour, parts that weren't on screen before
+    // come out as inside the set (black)
+    void reproject(precision oldZoom, complex centerDelta)
+    {
+        int width = state::currentWidth;
+        int height = state::currentHeight;
+        precision highestOfThem = std::max(width, height);
+        precision oldPixelSpacing = oldZoom / highestOfThem;
+        precision newPixelSpacing = state::zoom / highestOfThem;
+
+        // pixel x of a view sits at x * spacing - width * spacing / 2 from its center
+        auto oldPixelIndex = [&](int newIndex, int size, precision delta)
+        {
+            precision offset = newIndex * newPixelSpacing - size * newPixelSpacing / 2 + delta;
+            return (int)std::lround(offset / oldPixelSpacing + size / 2.0);
+        };
 
-        int startPixel = 0;
-        for (int i = 0; i < num_threads - nExtraPixels; ++i)
+        std::vector<int> sourceX(width);
+        for (int x = 0; x < width; ++x)
         {
-            threadPool[i] = std::thread(computePiece, std::ref(textureData), zoom, centralPoint, width, height, startPixel, nPixelsPerThread, i);
-            startPixel += nPixelsPerThread;
+            sourceX[x] = oldPixelIndex(x, width, centerDelta.r);
         }
-        for (int i = num_threads - nExtraPixels; i < num_threads; ++i)
+
+        std::vector<float> iterationCounts(size_t(width) * height);
+        std::vector<unsigned char> textureImage(size_t(width) * height * 3);
+        for (int y = 0; y < height; ++y)
         {
-            threadPool[i] = std::thread(computePiece, std::ref(textureData), zoom, centralPoint, width, height, startPixel, nPixelsPerThread + 1, i);
-            startPixel += nPixelsPerThread + 1;
+            int sourceY = oldPixelIndex(y, height, centerDelta.i);
+            for (int x = 0; x < width; ++x)
+            {
+                size_t destination = size_t(y) * width + x;
+                if (sourceY < 0 || sourceY >= height || sourceX[x] < 0 || sourceX[x] >= width)
+                {
+                    iterationCounts[destination] = is_in_mandelbrot_set;
+                    continue;
+                }
+                size_t source = size_t(sourceY) * width + sourceX[x];
+                iterationCounts[destination] = state::iterationCounts[source];
+                std::memcpy(&textureImage[destination * 3], &state::textureImage[source * 3], 3);
+            }
         }
-    }
-
-    void stop()
-    {
-        using namespace parallelMandelbrotState;
-        shouldStop.store(true);
-        join();
-        shouldStop.store(false);
-        setReadyThread(true);
-        hasTextureBeenUsed = true;
-    }
 
-    void stopIfComputing(){
-        if(isComputing()){
-            stop();
-        }
+        state::iterationCounts.swap(iterationCounts);
+        state::textureImage.swap(textureImage);
+        zoomReprojectionState::doBuffersShowCurrentView = true;
     }
 }
 
+#ifndef HEADLESS
 namespace inputHandler
 {
 
@@ -494,7 +2207,8 @@ namespace inputHandler
     }
 
     bool isInDragMode = false;
-    complex dragPoint;
+    BigComplex dragStartCentralPoint;
+    complex dragStartCursorOffset;
     void mouseButtonCallback(GLFWwindow *window, int button, int action, int mods)
     {
         if (!isWindowInFocus)
@@ -506,20 +2220,76 @@ namespace inputHandler
         {
             if (action == GLFW_PRESS)
             {
-                dragPoint = getComplexNumberCursorPointsToInWindow(window);
+                dragStartCentralPoint = state::deepCentralPoint;
+                dragStartCursorOffset = getCursorOffsetFromCentralPoint(window, state::zoom);
                 isInDragMode = true;
                 mandelbrotCalculator::parallelMandelbrot::stopIfComputing();
+                mandelbrotCalculator::incrementalPan::begin();
+                if (!mandelbrotCalculator::incrementalPan::isActive())
+                {
+                    // the previews move the view but render into buffers of their own
+                    mandelbrotCalculator::zoomReprojection::buffersNoLongerShowCurrentView();
+                }
             }
 
             if (action == GLFW_RELEASE)
             {
                 isInDragMode = false;
 
-                mandelbrotCalculator::parallelMandelbrot::computeParallel(state::textureImage, state::zoom, state::centralPoint, state::currentWidth, state::currentHeight);
+                if (mandelbrotCalculator::incrementalPan::isActive())
+                {
+                    // the buffers already hold the whole view at full resolution
+                    mandelbrotCalculator::incrementalPan::end();
+                }
+                else
+                {
+                    mandelbrotCalculator::zoomReprojection::buffersNoLongerShowCurrentView();
+                    mandelbrotCalculator::computeCurrentView(state::textureImage, state::iterationCounts, state::currentWidth, state::currentHeight, progressiveRenderCoarsestStep);
+                }
             }
         }
     }
 
+    // the left and right arrows rotate the palette, A turns anti-aliasing on and off, B switches
+    // between boundary tracing and Mariani-Silver, M cycles when Mariani-Silver fills, P cycles
+    // what views too deep for double use
+    float pendingHueShift = 0;
+    bool shouldToggleAntiAliasing = false;
+    bool shouldToggleBoundaryTracing = false;
+    bool shouldCycleFillCheck = false;
+    bool shouldCycleDeepTier = false;
+    void keyCallback(GLFWwindow *window, int key, int scancode, int action, int mods)
+    {
+        if (action == GLFW_RELEASE)
+        {
+            return;
+        }
+        if (key == GLFW_KEY_LEFT)
+        {
+            pendingHueShift -= 15;
+        }
+        if (key == GLFW_KEY_RIGHT)
+        {
+            pendingHueShift += 15;
+        }
+        if (key == GLFW_KEY_A && action == GLFW_PRESS)
+        {
+            shouldToggleAntiAliasing = true;
+        }
+        if (key == GLFW_KEY_B && action == GLFW_PRESS)
+        {
+            shouldToggleBoundaryTracing = true;
+        }
+        if (key == GLFW_KEY_M && action == GLFW_PRESS)
+        {
+            shouldCycleFillCheck = true;
+        }
+        if (key == GLFW_KEY_P && action == GLFW_PRESS)
+        {
+            shouldCycleDeepTier = true;
+        }
+    }
+
     bool shouldZoomScroll = false;
     double yOffsetLastScroll;
     void scrollCallback(GLFWwindow *window, double xOffset, double yOffset)
@@ -536,33 +2306,38 @@ namespace inputHandler
 
             glViewport(0, 0, state::currentWidth, state::currentHeight);
 
-            // Regenerate texture data
-            std::vector<unsigned char> newTextureData;
-
-            int previewWidth = state::currentWidth / previewTextureSizeFactor;
-            int previewHeight = state::currentHeight / previewTextureSizeFactor;
-
-            mandelbrotCalculator::parallelMandelbrot::computeParallel(newTextureData, state::zoom, state::centralPoint, previewWidth, previewHeight);
-            mandelbrotCalculator::parallelMandelbrot::join();
-            newTextureSize(newTextureData, previewWidth, previewHeight, state::shaderProgram);
-            mandelbrotCalculator::parallelMandelbrot::imUsingTheTexture();
-
-            mandelbrotCalculator::parallelMandelbrot::computeParallel(state::textureImage, state::zoom, state::centralPoint, state::currentWidth, state::currentHeight);
+            // the old texture stays stretched over the window until the first, coarse pass is done
+            mandelbrotCalculator::zoomReprojection::buffersNoLongerShowCurrentView();
+            mandelbrotCalculator::computeCurrentView(state::textureImage, state::iterationCounts, state::currentWidth, state::currentHeight, progressiveRenderCoarsestStep);
 
             shouldResize = false;
         }
 
-        if (isInDragMode)
+        if (isInDragMode && mandelbrotCalculator::incrementalPan::isActive())
+        {
+            // keep the point grabbed at the press under the cursor, to the nearest pixel
+            complex cursorOffset = getCursorOffsetFromCentralPoint(state::window, state::zoom);
+            complex offset{dragStartCursorOffset.r - cursorOffset.r, dragStartCursorOffset.i - cursorOffset.i};
+            if (mandelbrotCalculator::incrementalPan::panTo(dragStartCentralPoint, offset))
+            {
+                // the moved frame goes up before the workers write into the exposed strips
+                newTextureSize(state::textureImage, state::currentWidth, state::currentHeight, state::shaderProgram);
+                mandelbrotCalculator::incrementalPan::computeExposedRegions();
+            }
+        }
+        else if (isInDragMode)
         {
-            double x, y;
-            getNormalizedCursorPositionInWindow(state::window, x, y);
-            state::centralPoint = numberCentralShouldBeToMakePointBeInNormalizedWindow(dragPoint, state::zoom, x, y);
+            // keep the point grabbed at the press under the cursor
+            complex cursorOffset = getCursorOffsetFromCentralPoint(state::window, state::zoom);
+            state::deepCentralPoint = dragStartCentralPoint;
+            moveCentralPointBy(complex{dragStartCursorOffset.r - cursorOffset.r, dragStartCursorOffset.i - cursorOffset.i});
             std::vector<unsigned char> texture;
+            std::vector<float> previewIterationCounts;
 
             int previewWidth = state::currentWidth / previewTextureSizeFactor;
             int previewHeight = state::currentHeight / previewTextureSizeFactor;
 
-            mandelbrotCalculator::parallelMandelbrot::computeParallel(texture, state::zoom, state::centralPoint, previewWidth, previewHeight);
+            mandelbrotCalculator::computeCurrentView(texture, previewIterationCounts, previewWidth, previewHeight);
             mandelbrotCalculator::parallelMandelbrot::join();
             newTextureSize(texture, previewWidth, previewHeight, state::shaderProgram);
             mandelbrotCalculator::parallelMandelbrot::imUsingTheTexture();
@@ -571,32 +2346,156 @@ namespace inputHandler
         if (shouldZoomScroll)
         {
             mandelbrotCalculator::parallelMandelbrot::stopIfComputing();
-            complex zoomPoint = getComplexNumberCursorPointsToInWindow(state::window);
+            // keep the point under the cursor where it is
+            complex oldCursorOffset = getCursorOffsetFromCentralPoint(state::window, state::zoom);
+            precision oldZoom = state::zoom;
+            state::zoom = std::max(state::zoom * (precision)std::pow(baseForZoomScrollFunction, float(yOffsetLastScroll)), mandelbrotCalculator::deepZoom::deepestZoom);
+            complex newCursorOffset = getCursorOffsetFromCentralPoint(state::window, state::zoom);
+            complex centerDelta{oldCursorOffset.r - newCursorOffset.r, oldCursorOffset.i - newCursorOffset.i};
+            moveCentralPointBy(centerDelta);
+
+            // the last frame scaled around the cursor, until the render below replaces it. It's
+            // sharper than a coarse pass would be, so the render goes straight to full resolution
+            int coarsestStep = progressiveRenderCoarsestStep;
+            if (mandelbrotCalculator::zoomReprojection::canReproject())
+            {
+                mandelbrotCalculator::zoomReprojection::reproject(oldZoom, centerDelta);
+                newTextureSize(state::textureImage, state::currentWidth, state::currentHeight, state::shaderProgram);
+                coarsestStep = 1;
+            }
 
-            double x, y;
-            getNormalizedCursorPositionInWindow(state::window, x, y);
+            mandelbrotCalculator::computeCurrentView(state::textureImage, state::iterationCounts, state::currentWidth, state::currentHeight, coarsestStep);
 
-            precision newZoom = state::zoom * (precision)std::pow(baseForZoomScrollFunction, float(yOffsetLastScroll));
-            state::centralPoint = numberCentralShouldBeToMakePointBeInNormalizedWindow(zoomPoint, newZoom, x, y);
-            state::zoom = newZoom;
-            std::vector<unsigned char> texture;
+            shouldZoomScroll = false;
+        }
 
-            int previewWidth = state::currentWidth / previewTextureSizeFactor;
-            int previewHeight = state::currentHeight / previewTextureSizeFactor;
+        // the workers color with the palette, so it only changes between renders. The finished
+        // image is then recolored from its iteration counts instead of being computed again
+        if (pendingHueShift != 0 && !isInDragMode && !mandelbrotCalculator::parallelMandelbrot::isComputing())
+        {
+            palette::shiftHue(coloringState::currentPalette, pendingHueShift);
+            pendingHueShift = 0;
 
-            mandelbrotCalculator::parallelMandelbrot::computeParallel(texture, state::zoom, state::centralPoint, previewWidth, previewHeight);
-            mandelbrotCalculator::parallelMandelbrot::join();
-            newTextureSize(texture, previewWidth, previewHeight, state::shaderProgram);
-            mandelbrotCalculator::parallelMandelbrot::imUsingTheTexture();
+            // the anti-aliased pixels are colored again from their kept samples, not iterated again
+            colorIterationCounts(state::textureImage.data(), state::iterationCounts.data(), state::iterationCounts.size());
+            if (mandelbrotCalculator::antiAliasing::antiAliasingState::isEnabled && mandelbrotCalculator::parallelMandelbrot::didLastRenderFinish())
+            {
+                mandelbrotCalculator::antiAliasing::recolorKeptSamples(state::textureImage.data(), state::currentWidth);
+            }
+            newTextureSize(state::textureImage, state::currentWidth, state::currentHeight, state::shaderProgram);
+        }
 
-            mandelbrotCalculator::parallelMandelbrot::computeParallel(state::textureImage, state::zoom, state::centralPoint, state::currentWidth, state::currentHeight);
+        // turned on, the finished view gets its anti-aliasing pass, turned off it's recolored from
+        // its single samples
+        if (shouldToggleAntiAliasing && !isInDragMode && !mandelbrotCalculator::parallelMandelbrot::isComputing())
+        {
+            shouldToggleAntiAliasing = false;
+            bool &isEnabled = mandelbrotCalculator::antiAliasing::antiAliasingState::isEnabled;
+            isEnabled = !isEnabled;
+            std::cout << "anti-aliasing " << (isEnabled ? "on" : "off") << "\n";
 
-            shouldZoomScroll = false;
+            if (isEnabled)
+            {
+                mandelbrotCalculator::parallelMandelbrot::startAntiAliasingPass();
+            }
+            else if (mandelbrotCalculator::parallelMandelbrot::didLastRenderFinish())
+            {
+                colorIterationCounts(state::textureImage.data(), state::iterationCounts.data(), state::iterationCounts.size());
+                newTextureSize(state::textureImage, state::currentWidth, state::currentHeight, state::shaderProgram);
+            }
+        }
+
+        // the workers read it, so it switches between renders. It only changes how fast the
+        // pixels are found, the next render uses it
+        if (shouldToggleBoundaryTracing && !mandelbrotCalculator::parallelMandelbrot::isComputing())
+        {
+            shouldToggleBoundaryTracing = false;
+            bool &isEnabled = mandelbrotCalculator::boundaryTracing::boundaryTracingState::isEnabled;
+            isEnabled = !isEnabled;
+            std::cout << "boundary tracing " << (isEnabled ? "on" : "off") << "\n";
+        }
+
+        // same for the check before Mariani-Silver fills a rectangle
+        if (shouldCycleFillCheck && !mandelbrotCalculator::parallelMandelbrot::isComputing())
+        {
+            shouldCycleFillCheck = false;
+            using namespace mandelbrotCalculator::marianiSilver;
+            Verification &verification = marianiSilverState::verification;
+            verification = verification == trustBorder ? checkCenter : verification == checkCenter ? neverFill : trustBorder;
+            std::cout << "fill check " << verificationName(verification) << "\n";
+        }
+
+        // also only between renders, the tier is picked when one starts. A view deep enough to use
+        // it is rendered again, the old image stays up until the new one replaces it
+        if (shouldCycleDeepTier && !isInDragMode && !mandelbrotCalculator::parallelMandelbrot::isComputing())
+        {
+            shouldCycleDeepTier = false;
+            using namespace mandelbrotCalculator::numericTier;
+            Tier &deepTier = numericTierState::deepTier;
+            deepTier = deepTier == perturbationTier ? doubleDoubleTier : deepTier == doubleDoubleTier ? quadDoubleTier : perturbationTier;
+            std::cout << "precision " << deepTierName(deepTier) << "\n";
+
+            if (currentTier() != floatTier && currentTier() != doubleTier)
+            {
+                mandelbrotCalculator::computeCurrentView(state::textureImage, state::iterationCounts, state::currentWidth, state::currentHeight);
+            }
         }
     }
 
 }
 
+// uploads the tiles the workers finished since the last call, so a render fills in tile by tile
+// instead of arriving in one upload at the end. Only for renders of state::textureImage into a texture
+// of their size already, false otherwise (after a resize, or with a preview in the texture), and
+// the render has to be uploaded whole with newTextureSize once it's done
+bool uploadFinishedTiles()
+{
+    using namespace mandelbrotCalculator::parallelMandelbrot;
+    const parallelMandelbrotState::RenderJob &job = parallelMandelbrotState::currentJob;
+    if (job.textureData != &state::textureImage || job.width != state::textureWidth || job.height != state::textureHeight)
+    {
+        return false;
+    }
+
+    std::vector<parallelMandelbrotState::RenderTile> tiles;
+    parallelMandelbrotState::RenderTile tile;
+    size_t byteCount = 0;
+    while (takeFinishedTile(tile))
+    {
+        tiles.push_back(tile);
+        byteCount += size_t(tile.x1 - tile.x0) * (tile.y1 - tile.y0) * 3;
+    }
+    if (tiles.empty())
+    {
+        return true;
+    }
+
+    // the tiles go into the pixel buffer one after the other, each packed tight
+    auto write = [&](unsigned char *buffer)
+    {
+        for (const parallelMandelbrotState::RenderTile &tile : tiles)
+        {
+            size_t rowBytes = size_t(tile.x1 - tile.x0) * 3;
+            for (int y = tile.y0; y < tile.y1; ++y)
+            {
+                std::memcpy(buffer, job.textureData->data() + (size_t(y) * job.width + tile.x0) * 3, rowBytes);
+                buffer += rowBytes;
+            }
+        }
+    };
+    auto upload = [&]
+    {
+        size_t offset = 0;
+        for (const parallelMandelbrotState::RenderTile &tile : tiles)
+        {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, tile.x0, tile.y0, tile.x1 - tile.x0, tile.y1 - tile.y0, GL_RGB, GL_UNSIGNED_BYTE, pixelBufferRing::bufferOffset(offset));
+            offset += size_t(tile.x1 - tile.x0) * (tile.y1 - tile.y0) * 3;
+        }
+    };
+    pixelBufferRing::uploadThroughPixelBuffer(byteCount, write, upload);
+    return true;
+}
+
 int main()
 {
 
@@ -604,6 +2503,7 @@ int main()
     GLuint texture;
 
     mandelbrotCalculator::parallelMandelbrot::initialize();
+    std::cout << "escape time kernel: " << kernelInstructionSetName() << "\n";
 
     { // things which i dont know exactly how they work
         // Initialize GLFW
@@ -638,11 +2538,12 @@ int main()
         glGenTextures(1, &texture);
         glBindTexture(GL_TEXTURE_2D, texture);
         {
-            std::vector<unsigned char> textureData(1000 * 1000 * 3);
-            mandelbrotCalculator::parallelMandelbrot::computeParallel(textureData, state::zoom, state::centralPoint, state::currentWidth, state::currentHeight);
+            mandelbrotCalculator::computeCurrentView(state::textureImage, state::iterationCounts, state::currentWidth, state::currentHeight);
             mandelbrotCalculator::parallelMandelbrot::join();
             mandelbrotCalculator::parallelMandelbrot::imUsingTheTexture();
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, state::currentWidth, state::currentHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, textureData.data());
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, state::currentWidth, state::currentHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, state::textureImage.data());
+            state::textureWidth = state::currentWidth;
+            state::textureHeight = state::currentHeight;
         }
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -716,6 +2617,7 @@ int main()
     glfwSetMouseButtonCallback(state::window, inputHandler::mouseButtonCallback);
     glfwSetWindowFocusCallback(state::window, inputHandler::windowFocusCallback);
     glfwSetScrollCallback(state::window, inputHandler::scrollCallback);
+    glfwSetKeyCallback(state::window, inputHandler::keyCallback);
 
     // main loop
     while (!glfwWindowShouldClose(state::window))
@@ -725,10 +2627,27 @@ int main()
 
         inputHandler::runEvents();
 
-        if (mandelbrotCalculator::parallelMandelbrot::isTextureReady())
+        // checked before the upload, so a pass that's done has all of its tiles in the upload
+        bool isPassDone = mandelbrotCalculator::parallelMandelbrot::isTextureReady();
+        bool wereTilesUploaded = uploadFinishedTiles();
+        if (isPassDone)
         {
-            newTextureSize(state::textureImage, state::currentWidth, state::currentHeight, state::shaderProgram);
+            if (!wereTilesUploaded)
+            {
+                newTextureSize(state::textureImage, state::currentWidth, state::currentHeight, state::shaderProgram);
+            }
             mandelbrotCalculator::parallelMandelbrot::imUsingTheTexture();
+            mandelbrotCalculator::parallelMandelbrot::refineIfNeeded();
+        }
+
+        // not while dragging, a render again would replace the drag's. The last one is learned from
+        // once the drag ends
+        if (!inputHandler::isInDragMode && mandelbrotCalculator::iterationBudget::learnFromFinishedRender())
+        {
+            // the budget cut off detail, the view gets rendered again with the raised one. At full
+            // resolution right away, the finished image stays up meanwhile and coarse passes would
+            // only blur it
+            mandelbrotCalculator::computeCurrentView(state::textureImage, state::iterationCounts, state::currentWidth, state::currentHeight);
         }
 
         // Render
@@ -758,9 +2677,7 @@ int main()
     }
 
     { // clean up
-        if(!mandelbrotCalculator::parallelMandelbrot::parallelMandelbrotState::haveIalreadyJoined){
-            mandelbrotCalculator::parallelMandelbrot::join();
-        }
+        mandelbrotCalculator::parallelMandelbrot::terminate();
         glDeleteVertexArrays(1, &VAO);
         glDeleteBuffers(1, &VBO);
         glDeleteTextures(1, &texture);
@@ -770,3 +2687,417 @@ int main()
 
     return 0;
 }
+#else
+
+// renders one view into an image file, for machines without a display and for timing the engine:
+//   mandelbrot --center <re> <im> --zoom <zoom> --size <width> <height> [--iterations <count>] --output <file>
+// The center is plain decimal, with as many digits as the zoom needs. Zoom is the width of the view,
+// like state::zoom. Without --iterations the budget adapts like in the window, the view is rendered
+// again until it's high enough. A file ending in .png is written as PNG, anything else as PPM.
+// With --zoom-to it writes a zoom animation from --zoom to that zoom instead, a numbered file per
+// frame and --frames-per-step frames (30 by default) per baseForZoomScrollFunction step. --antialias n
+// gives the pixels on edges and in noisy areas n x n samples
+namespace commandLine
+{
+    // images with more pixels than this are rendered and written a band of rows at a time, so memory
+    // stays bounded however big the image is (a 50k x 50k print is 2.5 gigapixels)
+    constexpr long long pixelsPerBand = 1 << 24;
+    constexpr long long pixelsPerBudgetPreview = 1 << 20;
+
+    // the bands have to share one budget, so it adapts on a render of the whole view at about a
+    // megapixel first and is fixed after that
+    void fixIterationBudgetFromPreview(int width, int height)
+    {
+        using namespace mandelbrotCalculator;
+        double scale = std::sqrt(double(width) * height / pixelsPerBudgetPreview);
+        int previewWidth = std::max(1, int(width / scale));
+        int previewHeight = std::max(1, int(height / scale));
+        do
+        {
+            computeCurrentView(state::textureImage, state::iterationCounts, previewWidth, previewHeight);
+            parallelMandelbrot::join();
+        } while (iterationBudget::learnFromFinishedRender());
+        iterationBudget::iterationBudgetState::fixedBudget = max_iterations;
+    }
+
+    // renders the view at state::zoom around state::deepCentralPoint band by band from the top, every
+    // band a view of its own around its middle with the same pixel spacing, and streams them into the
+    // file. Returns how many bands it took, 0 when the file couldn't be written
+    int renderInBands(const std::string &outputPath, int width, int height)
+    {
+        using namespace mandelbrotCalculator;
+
+        int bandHeight = std::max(1, int(pixelsPerBand / width));
+        int bandCount = (height + bandHeight - 1) / bandHeight;
+        precision pixelSpacing = state::zoom / std::max(width, height);
+        BigComplex center = state::deepCentralPoint;
+
+        imageFile::ImageStream image;
+        if (!imageFile::beginImage(image, outputPath, width, height))
+        {
+            return 0;
+        }
+        for (int band = 0; band < bandCount; ++band)
+        {
+            // row 0 is the bottom of the image, and the file starts at the top
+            int y1 = height - band * bandHeight;
+            int y0 = std::max(0, y1 - bandHeight);
+            int rows = y1 - y0;
+
+            precision offset = (y0 + rows / precision(2) - height / precision(2)) * pixelSpacing;
+            state::deepCentralPoint = BigComplex{center.r, center.i + bigFixedFromDouble(offset, fractionalLimbsForZoom(state::zoom))};
+            state::centralPoint = complex{bigFixedToDouble(state::deepCentralPoint.r), bigFixedToDouble(state::deepCentralPoint.i)};
+            precision zoom = state::zoom;
+            state::zoom = pixelSpacing * std::max(width, rows);
+
+            computeCurrentView(state::textureImage, state::iterationCounts, width, rows);
+            parallelMandelbrot::finish();
+            state::zoom = zoom;
+
+            if (!imageFile::writeBand(image, state::textureImage.data(), rows))
+            {
+                imageFile::endImage(image);
+                return 0;
+            }
+            std::cout << "\rband " << band + 1 << "/" << bandCount << std::flush;
+        }
+        std::cout << "\n";
+        state::deepCentralPoint = center;
+        return imageFile::endImage(image) ? bandCount : 0;
+    }
+
+    // a zoom animation from state::zoom down to some end zoom around state::deepCentralPoint. Only
+    // keyframes get rendered, one per baseForZoomScrollFunction step (a scroll notch in the window),
+    // and the frames between two keyframes are resampled from them. At 30 frames per step that's a
+    // render for every 30 frames instead of every frame
+    namespace zoomSequence
+    {
+        struct Keyframe
+        {
+            int index = -1; // its zoom is the start zoom * baseForZoomScrollFunction^index
+            std::vector<unsigned char> textureImage;
+        };
+
+        void renderKeyframe(Keyframe &keyframe, int index, precision startZoom, int width, int height)
+        {
+            using namespace mandelbrotCalculator;
+            state::zoom = startZoom * std::pow(precision(baseForZoomScrollFunction), precision(index));
+            do
+            {
+                computeCurrentView(state::textureImage, state::iterationCounts, width, height);
+                parallelMandelbrot::join();
+            } while (iterationBudget::learnFromFinishedRender());
+            parallelMandelbrot::finish();
+            keyframe.index = index;
+            keyframe.textureImage.swap(state::textureImage);
+        }
+
+        // pixel u of a view sits at (u - size / 2) * spacing from the center, so the pixel of the
+        // frame at x is at u = (x - size / 2) * frame spacing / keyframe spacing + size / 2 in the keyframe
+        inline float keyframePosition(int x, int size, precision scale)
+        {
+            return float((x - size / precision(2)) * scale + size / precision(2));
+        }
+
+        inline void sampleBilinear(const unsigned char image[], int width, int height, float u, float v, unsigned char out[])
+        {
+            int x0 = std::min(std::max(int(std::floor(u)), 0), std::max(width - 2, 0));
+            int y0 = std::min(std::max(int(std::floor(v)), 0), std::max(height - 2, 0));
+            int x1 = std::min(x0 + 1, width - 1);
+            int y1 = std::min(y0 + 1, height - 1);
+            float fx = std::min(std::max(u - x0, 0.0f), 1.0f);
+            float fy = std::min(std::max(v - y0, 0.0f), 1.0f);
+
+            const unsigned char *a = image + (size_t(y0) * width + x0) * 3;
+            const unsigned char *b = image + (size_t(y0) * width + x1) * 3;
+            const unsigned char *c = image + (size_t(y1) * width + x0) * 3;
+            const unsigned char *d = image + (size_t(y1) * width + x1) * 3;
+            for (int channel = 0; channel < 3; ++channel)
+            {
+                float top = a[channel] + (b[channel] - a[channel]) * fx;
+                float bottom = c[channel] + (d[channel] - c[channel]) * fx;
+                out[channel] = (unsigned char)(top + (bottom - top) * fy + 0.5f);
+            }
+        }
+
+        // the frame stepsIn steps (0 to 1) past the outer keyframe. Where the inner keyframe, one step
+        // deeper, reaches it gives the detail, the rest comes from the outer one magnified by less
+        // than 1 / baseForZoomScrollFunction
+        void synthesizeFrame(unsigned char frame[], const Keyframe &outer, const Keyframe &inner, double stepsIn, int width, int height)
+        {
+            precision outerScale = std::pow(precision(baseForZoomScrollFunction), precision(stepsIn));
+            precision innerScale = outerScale / baseForZoomScrollFunction;
+
+            std::vector<float> outerU(width), innerU(width);
+            for (int x = 0; x < width; ++x)
+            {
+                outerU[x] = keyframePosition(x, width, outerScale);
+                innerU[x] = keyframePosition(x, width, innerScale);
+            }
+
+            for (int y = 0; y < height; ++y)
+            {
+                float outerV = keyframePosition(y, height, outerScale);
+                float innerV = keyframePosition(y, height, innerScale);
+                bool isRowInInner = innerV >= 0 && innerV <= height - 1;
+                unsigned char *row = frame + size_t(y) * width * 3;
+                for (int x = 0; x < width; ++x)
+                {
+                    if (isRowInInner && innerU[x] >= 0 && innerU[x] <= width - 1)
+                    {
+                        sampleBilinear(inner.textureImage.data(), width, height, innerU[x], innerV, row + x * 3);
+                    }
+                    else
+                    {
+                        sampleBilinear(outer.textureImage.data(), width, height, outerU[x], outerV, row + x * 3);
+                    }
+                }
+            }
+        }
+
+        // "zoom.png" -> "zoom_00042.png", so the frames sort and ffmpeg can read them as zoom_%05d.png
+        std::string framePath(const std::string &outputPath, int frame)
+        {
+            size_t dot = outputPath.find_last_of('.');
+            size_t slash = outputPath.find_last_of("/\\");
+            if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+            {
+                dot = outputPath.size();
+            }
+            char number[16];
+            std::snprintf(number, sizeof(number), "_%05d", frame);
+            return outputPath.substr(0, dot) + number + outputPath.substr(dot);
+        }
+
+        // renders and writes the frames from state::zoom to endZoom, framesPerStep per
+        // baseForZoomScrollFunction step. Returns how many keyframes it took, 0 when a frame
+        // couldn't be written
+        int render(const std::string &outputPath, precision endZoom, int framesPerStep, int width, int height, int &frameCount)
+        {
+            // the keyframes only get magnified, so zooming out is the zoom in from endZoom with the
+            // frames numbered backwards
+            bool isZoomingOut = endZoom > state::zoom;
+            precision returnZoom = state::zoom;
+            precision startZoom = std::max(state::zoom, endZoom);
+            precision deepestZoom = std::min(state::zoom, endZoom);
+            double steps = std::log(deepestZoom / startZoom) / std::log(double(baseForZoomScrollFunction));
+            frameCount = std::max(0, int(std::lround(steps * framesPerStep))) + 1;
+
+            // the keyframes are always the two around the frame, inner one step deeper than outer
+            Keyframe outer;
+            Keyframe inner;
+            int keyframesRendered = 0;
+            std::vector<unsigned char> frame(size_t(width) * height * 3);
+            for (int f = 0; f < frameCount; ++f)
+            {
+                int index = f / framesPerStep;
+                int stepFrame = f % framesPerStep;
+                if (outer.index != index)
+                {
+                    if (inner.index == index)
+                    {
+                        std::swap(outer, inner);
+                    }
+                    else
+                    {
+                        renderKeyframe(outer, index, startZoom, width, height);
+                        ++keyframesRendered;
+                    }
+                }
+
+                const unsigned char *pixels = outer.textureImage.data();
+                if (stepFrame != 0)
+                {
+                    if (inner.index != index + 1)
+                    {
+                        renderKeyframe(inner, index + 1, startZoom, width, height);
+                        ++keyframesRendered;
+                    }
+                    synthesizeFrame(frame.data(), outer, inner, double(stepFrame) / framesPerStep, width, height);
+                    pixels = frame.data();
+                }
+
+                if (!imageFile::writeImage(framePath(outputPath, isZoomingOut ? frameCount - 1 - f : f), pixels, width, height))
+                {
+                    std::cout << "\n";
+                    return 0;
+                }
+                std::cout << "\rframe " << f + 1 << "/" << frameCount << std::flush;
+            }
+            std::cout << "\n";
+            state::zoom = returnZoom;
+            return keyframesRendered;
+        }
+    }
+}
+
+void printUsage()
+{
+    std::cout << "usage: mandelbrot --center <re> <im> --zoom <zoom> --size <width> <height> [--iterations <count>] --output <file.png|file.ppm>\n"
+                 "       [--antialias <samples per side>] [--boundary-tracing] [--fill-check never|border|center]\n"
+                 "       [--precision dd|qd|perturbation] [--zoom-to <end zoom> [--frames-per-step <count>]]\n";
+}
+
+int main(int argc, char *argv[])
+{
+    using namespace mandelbrotCalculator;
+
+    std::string centerReal = "-0.5";
+    std::string centerImaginary = "0";
+    precision zoom = 3;
+    int width = 1000;
+    int height = 1000;
+    std::string outputPath;
+    precision endZoom = 0; // 0 for a single image
+    int framesPerStep = 30;
+
+    for (int k = 1; k < argc; ++k)
+    {
+        std::string option = argv[k];
+        auto hasValues = [&](int count)
+        {
+            return k + count < argc;
+        };
+
+        if (option == "--center" && hasValues(2))
+        {
+            centerReal = argv[++k];
+            centerImaginary = argv[++k];
+        }
+        else if (option == "--zoom" && hasValues(1))
+        {
+            zoom = std::strtod(argv[++k], nullptr);
+        }
+        else if (option == "--size" && hasValues(2))
+        {
+            width = std::atoi(argv[++k]);
+            height = std::atoi(argv[++k]);
+        }
+        else if (option == "--iterations" && hasValues(1))
+        {
+            iterationBudget::iterationBudgetState::fixedBudget = std::atoi(argv[++k]);
+        }
+        else if (option == "--zoom-to" && hasValues(1))
+        {
+            endZoom = std::strtod(argv[++k], nullptr);
+        }
+        else if (option == "--frames-per-step" && hasValues(1))
+        {
+            framesPerStep = std::atoi(argv[++k]);
+        }
+        else if (option == "--antialias" && hasValues(1))
+        {
+            antiAliasing::antiAliasingState::samplesPerSide = std::atoi(argv[++k]);
+            antiAliasing::antiAliasingState::isEnabled = antiAliasing::antiAliasingState::samplesPerSide > 1;
+        }
+        else if (option == "--boundary-tracing")
+        {
+            boundaryTracing::boundaryTracingState::isEnabled = true;
+        }
+        else if (option == "--fill-check" && hasValues(1) && marianiSilver::verificationFromName(argv[k + 1], marianiSilver::marianiSilverState::verification))
+        {
+            ++k;
+        }
+        else if (option == "--precision" && hasValues(1) && numericTier::deepTierFromName(argv[k + 1], numericTier::numericTierState::deepTier))
+        {
+            ++k;
+        }
+        else if (option == "--output" && hasValues(1))
+        {
+            outputPath = argv[++k];
+        }
+        else if (option == "--help")
+        {
+            printUsage();
+            return 0;
+        }
+        else
+        {
+            std::cout << "unknown option or missing value: " << option << "\n";
+            printUsage();
+            return -1;
+        }
+    }
+
+    if (std::min(zoom, endZoom > 0 ? endZoom : zoom) < deepZoom::deepestZoom)
+    {
+        std::cout << "zooms below " << deepZoom::deepestZoom << " aren't supported, pixels can't be told apart in double there\n";
+        return -1;
+    }
+
+    // a zoom sequence needs the center as precise as its deepest frame
+    int fractionalLimbs = fractionalLimbsForZoom(endZoom > 0 ? std::min(zoom, endZoom) : zoom);
+    if (!(zoom > 0) || !(endZoom >= 0) || framesPerStep <= 0 || width <= 0 || height <= 0 || outputPath.empty() ||
+        !bigFixedFromString(centerReal, fractionalLimbs, state::deepCentralPoint.r) ||
+        !bigFixedFromString(centerImaginary, fractionalLimbs, state::deepCentralPoint.i))
+    {
+        printUsage();
+        return -1;
+    }
+    state::zoom = zoom;
+    state::centralPoint = complex{bigFixedToDouble(state::deepCentralPoint.r), bigFixedToDouble(state::deepCentralPoint.i)};
+    state::currentWidth = width;
+    state::currentHeight = height;
+
+    parallelMandelbrot::initialize();
+    auto startTime = std::chrono::steady_clock::now();
+
+    if (endZoom > 0)
+    {
+        int frames = 0;
+        int keyframes = commandLine::zoomSequence::render(outputPath, endZoom, framesPerStep, width, height, frames);
+        std::chrono::duration<double, std::milli> renderTime = std::chrono::steady_clock::now() - startTime;
+        parallelMandelbrot::terminate();
+        if (keyframes == 0)
+        {
+            std::cout << "couldn't write the frames of " << outputPath << "\n";
+            return -1;
+        }
+
+        std::cout << "rendered and wrote " << frames << " frames of " << width << "x" << height << " in " << renderTime.count() << " ms ("
+                  << keyframes << " keyframes, " << max_iterations << " iterations in the last, " << kernelInstructionSetName() << " kernel)\n";
+        return 0;
+    }
+
+    if (double(width) * height > commandLine::pixelsPerBand)
+    {
+        if (iterationBudget::iterationBudgetState::fixedBudget == 0)
+        {
+            commandLine::fixIterationBudgetFromPreview(width, height);
+        }
+        int bands = commandLine::renderInBands(outputPath, width, height);
+        std::chrono::duration<double, std::milli> renderTime = std::chrono::steady_clock::now() - startTime;
+        parallelMandelbrot::terminate();
+        if (bands == 0)
+        {
+            std::cout << "couldn't write " << outputPath << "\n";
+            return -1;
+        }
+
+        std::cout << "rendered and wrote " << width << "x" << height << " in " << renderTime.count() << " ms (" << bands << " bands, "
+                  << max_iterations << " iterations, " << kernelInstructionSetName() << " kernel)\n";
+        return 0;
+    }
+
+    int renders = 0;
+    do
+    {
+        computeCurrentView(state::textureImage, state::iterationCounts, width, height);
+        parallelMandelbrot::join();
+        ++renders;
+    } while (iterationBudget::learnFromFinishedRender());
+    parallelMandelbrot::finish();
+    std::chrono::duration<double, std::milli> renderTime = std::chrono::steady_clock::now() - startTime;
+    parallelMandelbrot::terminate();
+
+    std::cout << "rendered " << width << "x" << height << " in " << renderTime.count() << " ms (" << renders << " renders, "
+              << max_iterations << " iterations, " << kernelInstructionSetName() << " kernel)\n";
+
+    if (!imageFile::writeImage(outputPath, state::textureImage.data(), width, height))
+    {
+        std::cout << "couldn't write " << outputPath << "\n";
+        return -1;
+    }
+    return 0;
+}
+#endif